@@ -17,6 +17,7 @@
  */
 
 #include "dict_object.h"
+#include "dictionarycache.h"
 #include <QDebug>
 #include <KLocalizedString>
 #include <QQuickWebEngineProfile>
@@ -67,8 +68,14 @@ void DictObject::lookup(const QString &word)
     }
 
     if (!newSource.isEmpty()) {
-        // Look up new definition
+        // Look up new definition, asking the server only for words not seen before
         emit searchInProgress();
+        QString definition;
+        if (DictionaryCache::lookup(m_selectedDict, word, &definition)) {
+            m_source.clear();
+            emit definitionFound(definition);
+            return;
+        }
         m_source = newSource;
         m_dataEngine->connectSource(m_source, this);
     }
@@ -76,9 +83,12 @@ void DictObject::lookup(const QString &word)
 
 void DictObject::dataUpdated(const QString &sourceName, const Plasma::DataEngine::Data &data)
 {
-    Q_UNUSED(sourceName); // always == m_source
     const QString html = data.value(QStringLiteral("text")).toString();
     if (!html.isEmpty()) {
+        QString dictionary;
+        QString word;
+        DictionaryCache::splitSource(sourceName, &dictionary, &word); // always == m_source
+        DictionaryCache::insert(dictionary, word, html);
         emit definitionFound(html);
     }
 }
@@ -18,6 +18,7 @@
 
 import QtQuick 2.5
 import QtQuick.Layouts 1.1
+import QtQuick.Window 2.2
 import QtQuick.Dialogs 1.2
 import QtQuick.Controls 1.3
 import QtQuick.Controls.Styles 1.2
@@ -37,6 +38,10 @@ Item {
     MediaFrame {
         id: items
         random: plasmoid.configuration.randomize
+        // upcoming images get decoded at the size they are shown at, the image
+        // provider is asked for device pixels
+        imageSize: Qt.size(frontImage.sourceSize.width * frontImage.Screen.devicePixelRatio,
+                           frontImage.sourceSize.height * frontImage.Screen.devicePixelRatio)
     }
 
     Plasmoid.preferredRepresentation: plasmoid.fullRepresentation
@@ -202,10 +207,12 @@ Item {
                 opacity: 0
 
                 cache: false
-                source: transitionSource
+                source: items.imageSource(transitionSource)
 
                 asynchronous: true
                 autoTransform: true
+
+                sourceSize: frontImage.sourceSize
             }
 
             Image {
@@ -215,7 +222,7 @@ Item {
                 fillMode: plasmoid.configuration.fillMode
 
                 cache: false
-                source: activeSource
+                source: items.imageSource(activeSource)
 
                 asynchronous: true
                 autoTransform: true
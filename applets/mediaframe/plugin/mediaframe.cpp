@@ -17,10 +17,15 @@
  */
 
 #include "mediaframe.h"
+#include "mediaframeimageprovider.h"
+#include "mediaframeindex.h"
 
+#include <QDateTime>
 #include <QDir>
-#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
 #include <QFileInfo>
+#include <QSet>
 #include <QUrl>
 #include <QDebug>
 #include <QImageReader>
@@ -29,10 +34,108 @@
 #include <QRegularExpression>
 #include <QCryptographicHash>
 #include <QRandomGenerator>
+#include <QQmlEngine>
+#include <QStandardPaths>
 
-#include <KIO/StoredTransferJob>
+#include <KIO/FileCopyJob>
 #include <KIO/Job>
 
+namespace {
+
+// remote items are cached up to this size, the ones shown longest ago go first
+const qint64 s_maxCacheSize = 256 * 1024 * 1024;
+
+// this many items are downloaded ahead of being shown
+const int s_readAhead = 2;
+
+/**
+ * Walks a directory, reporting the media files found in batches.
+ *
+ * The listings come from the MediaFrameIndex, which reads only directories that
+ * changed since they were last scanned.
+ */
+class DirectoryScanner : public QObject, public QRunnable
+{
+    Q_OBJECT
+
+public:
+    DirectoryScanner(quint64 id, const QString &path, const QString &localPath, const QStringList &filters, bool recursive,
+                     const QSharedPointer<std::atomic<bool>> &cancelled)
+        : m_id(id)
+        , m_path(path)
+        , m_localPath(localPath)
+        , m_filters(filters)
+        , m_recursive(recursive)
+        , m_cancelled(cancelled)
+    {
+    }
+
+    void run() override
+    {
+        // a batch goes out once it is big or old enough, so the first pictures show up quickly
+        static const int maxBatchSize = 1000;
+        static const int maxBatchAge = 100;
+
+        MediaFrameIndex &index = MediaFrameIndex::instance();
+
+        // depth first and in name order, subdirectories are followed even when they are symlinks
+        QStringList pending(QDir::cleanPath(m_localPath));
+        QSet<QString> visited;
+        QStringList directories;
+
+        QStringList batch;
+        QElapsedTimer batchAge;
+        batchAge.start();
+        while (!*m_cancelled && !pending.isEmpty()) {
+            const QString path = pending.takeLast();
+            const QString canonicalPath = QFileInfo(path).canonicalFilePath();
+            if (canonicalPath.isEmpty() || visited.contains(canonicalPath)) {
+                continue;
+            }
+            visited.insert(canonicalPath);
+            directories.append(path);
+
+            const MediaFrameIndex::Directory directory = index.directory(path, m_filters);
+            for (const QString &file : directory.files) {
+                batch.append(path + QLatin1Char('/') + file);
+            }
+            if (m_recursive) {
+                for (auto it = directory.subdirectories.crbegin(); it != directory.subdirectories.crend(); ++it) {
+                    pending.append(path + QLatin1Char('/') + *it);
+                }
+            }
+
+            if (batch.count() >= maxBatchSize || (!batch.isEmpty() && batchAge.hasExpired(maxBatchAge))) {
+                emit filesFound(m_id, m_path, batch);
+                batch.clear();
+                batchAge.restart();
+            }
+        }
+        if (*m_cancelled) {
+            return;
+        }
+        if (!batch.isEmpty()) {
+            emit filesFound(m_id, m_path, batch);
+        }
+        index.save();
+        emit finished(m_id, m_path, directories);
+    }
+
+Q_SIGNALS:
+    void filesFound(quint64 id, const QString &path, const QStringList &files);
+    void finished(quint64 id, const QString &path, const QStringList &directories);
+
+private:
+    const quint64 m_id;
+    const QString m_path;
+    const QString m_localPath;
+    const QStringList m_filters;
+    const bool m_recursive;
+    const QSharedPointer<std::atomic<bool>> m_cancelled;
+};
+
+}
+
 MediaFrame::MediaFrame(QObject *parent) : QObject(parent)
 {
     const auto imageMimeTypeNames = QImageReader::supportedMimeTypes();
@@ -47,9 +150,29 @@ MediaFrame::MediaFrame(QObject *parent) : QObject(parent)
 
     connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, &MediaFrame::slotItemChanged);
     connect(&m_watcher, &QFileSystemWatcher::fileChanged, this, &MediaFrame::slotItemChanged);
+
+    // one directory at a time, the disk would only seek back and forth otherwise
+    m_scanPool.setMaxThreadCount(1);
+
+    // QML learns about a batch of files at once
+    m_countChangedTimer.setSingleShot(true);
+    m_countChangedTimer.setInterval(0);
+    connect(&m_countChangedTimer, &QTimer::timeout, this, &MediaFrame::countChanged);
+
+    connect(&m_directoryWatcher, &QFileSystemWatcher::directoryChanged, this, &MediaFrame::slotDirectoryChanged);
+    m_rescanTimer.setSingleShot(true);
+    m_rescanTimer.setInterval(1000);
+    connect(&m_rescanTimer, &QTimer::timeout, this, &MediaFrame::slotRescan);
 }
 
-MediaFrame::~MediaFrame() = default;
+MediaFrame::~MediaFrame()
+{
+    for (KJob *job : qAsConst(m_downloads)) {
+        job->kill();
+    }
+    cancelScans();
+    m_scanPool.waitForDone();
+}
 
 int MediaFrame::count() const
 {
@@ -69,6 +192,24 @@ void MediaFrame::setRandom(bool random)
     }
 }
 
+QSize MediaFrame::imageSize() const
+{
+    return m_imageSize;
+}
+
+void MediaFrame::setImageSize(const QSize &size)
+{
+    if (size != m_imageSize) {
+        m_imageSize = size;
+        emit imageSizeChanged();
+    }
+}
+
+QString MediaFrame::imageSource(const QString &path)
+{
+    return MediaFrameImageProvider::source(path);
+}
+
 int MediaFrame::random(int min, int max)
 {
     if (min > max) {
@@ -83,7 +224,8 @@ int MediaFrame::random(int min, int max)
 
 QString MediaFrame::getCacheDirectory()
 {
-    return QDir::temp().absolutePath();
+    // shared by all frames, and kept across sessions unlike the temporary directory
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/plasma_mediaframe/remote");
 }
 
 QString MediaFrame::hash(const QString &str)
@@ -91,6 +233,123 @@ QString MediaFrame::hash(const QString &str)
     return QString::fromLatin1(QCryptographicHash::hash(str.toUtf8(), QCryptographicHash::Md5).toHex());
 }
 
+QString MediaFrame::cachedPath(const QString &path)
+{
+    return getCacheDirectory() + QLatin1Char('/') + hash(path) + QLatin1Char('_') + path.section(QLatin1Char('/'), -1);
+}
+
+bool MediaFrame::isRemote(const QString &path)
+{
+    const QUrl url(path);
+    return url.isValid() && !isFile(url.toString(QUrl::PreferLocalFile));
+}
+
+QStringList MediaFrame::upcoming()
+{
+    if (m_allFiles.isEmpty()) {
+        return QStringList();
+    }
+
+    if (m_random) {
+        while (m_upcoming.count() < s_readAhead) {
+            m_upcoming.append(m_allFiles.at(random(0, m_allFiles.count() - 1)));
+        }
+        return m_upcoming;
+    }
+
+    QStringList paths;
+    for (int i = 0; i < qMin(s_readAhead, m_allFiles.count()); ++i) {
+        paths.append(m_allFiles.at((m_next + i) % m_allFiles.count()));
+    }
+    return paths;
+}
+
+void MediaFrame::readAhead()
+{
+    const QStringList paths = upcoming();
+    for (const QString &path : paths) {
+        if (isRemote(path) && !isFile(cachedPath(path))) {
+            download(path);
+        }
+    }
+}
+
+void MediaFrame::preloadUpcoming()
+{
+    QQmlEngine *engine = qmlEngine(this);
+    auto *provider = engine ? dynamic_cast<MediaFrameImageProvider *>(engine->imageProvider(MediaFrameImageProvider::name())) : nullptr;
+    if (!provider || m_imageSize.isEmpty()) {
+        return;
+    }
+
+    // remote items can only be decoded once they are downloaded
+    const QStringList paths = upcoming();
+    for (const QString &path : paths) {
+        if (!isRemote(path)) {
+            provider->preload(path, m_imageSize);
+        } else if (isFile(cachedPath(path))) {
+            provider->preload(cachedPath(path), m_imageSize);
+        }
+    }
+}
+
+void MediaFrame::download(const QString &path)
+{
+    if (m_downloads.contains(path)) {
+        return;
+    }
+
+    QDir().mkpath(getCacheDirectory());
+
+    // the file only gets its final name once complete, a partial download is never shown
+    const QUrl partUrl = QUrl::fromLocalFile(cachedPath(path) + QLatin1String(".part"));
+    KIO::FileCopyJob *job = KIO::file_copy(QUrl(path), partUrl, -1, KIO::Overwrite | KIO::HideProgressInfo);
+    m_downloads.insert(path, job);
+    connect(job, SIGNAL(result(KJob*)), this, SLOT(slotFinished(KJob*)));
+}
+
+void MediaFrame::trimCache()
+{
+    const QFileInfoList entries = QDir(getCacheDirectory()).entryInfoList(QDir::Files, QDir::Time);
+    const QDateTime abandoned = QDateTime::currentDateTimeUtc().addDays(-1);
+
+    // what is about to be shown stays, however much the cache holds, and so does what
+    // the frame goes back or forth to, history and future name the cached files
+    QSet<QString> kept;
+    for (const QString &path : qAsConst(m_history)) {
+        kept.insert(path);
+    }
+    for (const QString &path : qAsConst(m_future)) {
+        kept.insert(path);
+    }
+    if (!m_pendingPath.isEmpty()) {
+        kept.insert(cachedPath(m_pendingPath));
+    }
+    const QStringList paths = upcoming();
+    for (const QString &path : paths) {
+        kept.insert(cachedPath(path));
+    }
+
+    // most recently shown or downloaded first, see get() and slotFinished()
+    qint64 size = 0;
+    for (const QFileInfo &entry : entries) {
+        if (kept.contains(entry.absoluteFilePath())) {
+            continue;
+        }
+        if (entry.suffix() == QLatin1String("part")) {
+            // downloads cut short by a crash are never finished
+            if (entry.lastModified() < abandoned) {
+                QFile::remove(entry.absoluteFilePath());
+            }
+            continue;
+        }
+        size += entry.size();
+        if (size > s_maxCacheSize) {
+            QFile::remove(entry.absoluteFilePath());
+        }
+    }
+}
+
 bool MediaFrame::isDir(const QString &path)
 {
     return QDir(path).exists();
@@ -124,45 +383,22 @@ void MediaFrame::add(const QString &path, AddOption option)
     //qDebug() << "Local path" << localPath << "Path" << path;
 
     QStringList paths;
-    QString filePath;
 
     if(isDir(localPath)) {
 
-        if(!isDirEmpty(localPath))
-        {
-            QDirIterator dirIterator(localPath, m_filters, QDir::Files, (option == AddOption::RECURSIVE ? QDirIterator::Subdirectories | QDirIterator::FollowSymlinks : QDirIterator::NoIteratorFlags));
-
-            while (dirIterator.hasNext()) {
-                dirIterator.next();
-
-                filePath = dirIterator.filePath();
-                paths.append(filePath);
-                m_allFiles.append(filePath);
-                //qDebug() << "Appended" << filePath;
-                emit countChanged();
-            }
-            if(paths.count() > 0)
-            {
-                m_pathMap.insert(path, paths);
-                qDebug() << "Added" << paths.count() << "files from" << path;
-            }
-            else
-            {
-                qWarning() << "No images found in directory" << path;
-            }
-        }
-        else
-        {
-            qWarning() << "Not adding empty directory" << path;
-        }
-
-        // the pictures have to be sorted before adding them to the list,
-        // because the QDirIterator sorts them in a different way than QDir::entryList
-        //paths.sort();
+        // even an empty directory is scanned, so it gets watched for pictures to show up
+        // the files are added as the scanner finds them, see slotFilesFound
+        ScanRoot root;
+        root.localPath = localPath;
+        root.recursive = (option == AddOption::RECURSIVE);
+        m_scanRoots.insert(path, root);
+        m_paths.append(path);
+        scan(path, false);
 
     }
     else if(isFile(localPath))
     {
+        m_paths.append(path);
         paths.append(path);
         m_pathMap.insert(path, paths);
         m_allFiles.append(path);
@@ -174,6 +410,7 @@ void MediaFrame::add(const QString &path, AddOption option)
         if (url.isValid() && !url.isLocalFile())
         {
             qDebug() << "Adding" << url.toString() << "as remote file";
+            m_paths.append(path);
             paths.append(path);
             m_pathMap.insert(path, paths);
             m_allFiles.append(path);
@@ -189,11 +426,166 @@ void MediaFrame::add(const QString &path, AddOption option)
 
 void MediaFrame::clear()
 {
+    cancelScans();
+    m_upcoming.clear();
+    m_scanRoots.clear();
+    m_paths.clear();
+    if (!m_watchedDirectories.isEmpty()) {
+        m_directoryWatcher.removePaths(m_watchedDirectories.keys());
+        m_watchedDirectories.clear();
+    }
+    m_changedPaths.clear();
+    m_rescanTimer.stop();
     m_pathMap.clear();
     m_allFiles.clear();
+    m_countChangedTimer.stop();
     emit countChanged();
 }
 
+void MediaFrame::scan(const QString &path, bool refresh)
+{
+    const ScanRoot root = m_scanRoots.value(path);
+
+    auto it = m_scans.constFind(path);
+    if (it != m_scans.constEnd()) {
+        *it->cancelled = true;
+    }
+
+    Scan scan;
+    scan.id = ++m_nextScanId;
+    scan.cancelled = QSharedPointer<std::atomic<bool>>::create(false);
+    scan.refresh = refresh;
+
+    auto *scanner = new DirectoryScanner(scan.id, path, root.localPath, m_filters, root.recursive, scan.cancelled);
+    connect(scanner, &DirectoryScanner::filesFound, this, &MediaFrame::slotFilesFound);
+    connect(scanner, &DirectoryScanner::finished, this, &MediaFrame::slotScanFinished);
+    m_scans.insert(path, scan);
+    m_scanPool.start(scanner);
+}
+
+void MediaFrame::cancelScans()
+{
+    for (const Scan &scan : qAsConst(m_scans)) {
+        *scan.cancelled = true;
+    }
+    m_scans.clear();
+}
+
+void MediaFrame::countChangedLater()
+{
+    if (!m_countChangedTimer.isActive()) {
+        m_countChangedTimer.start();
+    }
+}
+
+void MediaFrame::slotFilesFound(quint64 scan, const QString &path, const QStringList &files)
+{
+    // batches of a cancelled scan may still be on their way, even once the path got added again
+    auto it = m_scans.find(path);
+    if (it == m_scans.end() || it->id != scan) {
+        return;
+    }
+    if (it->refresh) {
+        // the files already shown are replaced in one go once the scan finished
+        it->files.append(files);
+        return;
+    }
+    m_pathMap[path].append(files);
+    m_allFiles.append(files);
+    countChangedLater();
+}
+
+void MediaFrame::slotScanFinished(quint64 scan, const QString &path, const QStringList &directories)
+{
+    auto it = m_scans.find(path);
+    if (it == m_scans.end() || it->id != scan) {
+        return;
+    }
+    const Scan finished = *it;
+    m_scans.erase(it);
+
+    if (finished.refresh) {
+        m_pathMap.insert(path, finished.files);
+        m_upcoming.clear();
+        m_allFiles.clear();
+        for (const QString &added : qAsConst(m_paths)) {
+            m_allFiles.append(m_pathMap.value(added));
+        }
+        countChangedLater();
+    }
+    watchDirectories(path, directories);
+
+    const int count = m_pathMap.value(path).count();
+    if (count > 0) {
+        qDebug() << (finished.refresh ? "Updated" : "Added") << count << "files from" << path;
+    } else {
+        qWarning() << "No images found in directory" << path;
+    }
+}
+
+void MediaFrame::watchDirectories(const QString &path, const QStringList &directories)
+{
+    QSet<QString> scanned;
+    scanned.reserve(directories.count());
+    for (const QString &directory : directories) {
+        scanned.insert(directory);
+    }
+
+    // directories which are gone, or were moved out of the tree
+    QStringList unwatched;
+    for (auto it = m_watchedDirectories.begin(); it != m_watchedDirectories.end();) {
+        if (!scanned.contains(it.key()) && it->removeOne(path) && it->isEmpty()) {
+            unwatched.append(it.key());
+            it = m_watchedDirectories.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (!unwatched.isEmpty()) {
+        m_directoryWatcher.removePaths(unwatched);
+    }
+
+    QStringList watched;
+    for (const QString &directory : directories) {
+        QStringList &paths = m_watchedDirectories[directory];
+        if (paths.isEmpty()) {
+            watched.append(directory);
+        }
+        if (!paths.contains(path)) {
+            paths.append(path);
+        }
+    }
+    if (!watched.isEmpty()) {
+        m_directoryWatcher.addPaths(watched);
+    }
+}
+
+void MediaFrame::slotDirectoryChanged(const QString &directory)
+{
+    const QStringList paths = m_watchedDirectories.value(directory);
+    if (paths.isEmpty()) {
+        return;
+    }
+    for (const QString &path : paths) {
+        m_changedPaths.insert(path);
+    }
+    // copying a bunch of pictures causes many changes, one rescan is enough
+    if (!m_rescanTimer.isActive()) {
+        m_rescanTimer.start();
+    }
+}
+
+void MediaFrame::slotRescan()
+{
+    const QSet<QString> paths = m_changedPaths;
+    m_changedPaths.clear();
+    for (const QString &path : paths) {
+        if (m_scanRoots.contains(path)) {
+            scan(path, true);
+        }
+    }
+}
+
 void MediaFrame::watch(const QString &path)
 {
     QUrl url = QUrl(path);
@@ -222,7 +614,7 @@ void MediaFrame::watch(const QString &path)
 
 bool MediaFrame::isAdded(const QString &path)
 {
-    return (m_pathMap.contains(path));
+    return (m_pathMap.contains(path) || m_scanRoots.contains(path));
 }
 
 void MediaFrame::get(QJSValue successCallback)
@@ -259,8 +651,13 @@ void MediaFrame::get(QJSValue successCallback, QJSValue errorCallback)
     }
 
     if(m_random) {
-        path = m_allFiles.at(this->random(0, size));
+        path = m_upcoming.isEmpty() ? m_allFiles.at(this->random(0, size)) : m_upcoming.takeFirst();
     } else {
+        // the list may have shrunk since, when a directory was rescanned
+        if(m_next > size)
+        {
+            m_next = 0;
+        }
         path = m_allFiles.at(m_next);
         m_next++;
         if(m_next > size)
@@ -271,20 +668,28 @@ void MediaFrame::get(QJSValue successCallback, QJSValue errorCallback)
 
     }
 
+    // whatever comes next starts downloading and decoding while this one is shown
+    readAhead();
+    preloadUpcoming();
+
     QUrl url = QUrl(path);
 
     if(url.isValid()) {
         QString localPath = url.toString(QUrl::PreferLocalFile);
 
         if (!isFile(localPath)) {
-            m_filename = path.section(QLatin1Char('/'), -1);
-
-            QString cachedFile = getCacheDirectory()+QLatin1Char('/')+hash(path)+QLatin1Char('_')+m_filename;
+            const QString cachedFile = cachedPath(path);
 
             if(isFile(cachedFile)) {
                 // File has been cached
                 qDebug() << path << "is cached as" << cachedFile;
 
+                // the cache evicts the items shown longest ago
+                QFile file(cachedFile);
+                if (file.open(QIODevice::ReadOnly)) {
+                    file.setFileTime(QDateTime::currentDateTimeUtc(), QFileDevice::FileModificationTime);
+                }
+
                 if(successCallback.isCallable()) {
                     args << QJSValue(cachedFile);
                     successCallback.call(args);
@@ -292,14 +697,13 @@ void MediaFrame::get(QJSValue successCallback, QJSValue errorCallback)
                 return;
             }
 
+            m_pendingPath = path;
             m_successCallback = successCallback;
             m_errorCallback = errorCallback;
-            m_filename = cachedFile;
 
             qDebug() << path << "doesn't exist locally, trying remote.";
 
-            KIO::StoredTransferJob * job = KIO::storedGet( url, KIO::NoReload, KIO::HideProgressInfo);
-            connect(job, SIGNAL(finished(KJob*)), this, SLOT(slotFinished(KJob*)));
+            download(path);
 
         } else {
             if(successCallback.isCallable()) {
@@ -382,42 +786,56 @@ void MediaFrame::slotItemChanged(const QString &path)
 
 void MediaFrame::slotFinished(KJob *job)
 {
+    const QString path = m_downloads.key(job);
+    m_downloads.remove(path);
+
+    const QString cachedFile = cachedPath(path);
+    const QString partFile = cachedFile + QLatin1String(".part");
+
     QString errorMessage;
-    QJSValueList args;
 
     if (job->error()) {
         errorMessage = QLatin1String("Error loading image: ") + job->errorString();
-        qCritical() << errorMessage;
-
-        if(m_errorCallback.isCallable()) {
-            args << QJSValue(errorMessage);
-            m_errorCallback.call(args);
+    } else {
+        QFile::remove(cachedFile);
+        if (QFile::rename(partFile, cachedFile)) {
+            qDebug() << "Saved" << path << "to" << cachedFile;
+            // the modification time of the remote file got copied along
+            QFile file(cachedFile);
+            if (file.open(QIODevice::ReadOnly)) {
+                file.setFileTime(QDateTime::currentDateTimeUtc(), QFileDevice::FileModificationTime);
+            }
+            trimCache();
+            preloadUpcoming();
+        } else {
+            errorMessage = QLatin1String("Error caching image as ") + cachedFile;
         }
-    } else if (KIO::StoredTransferJob *transferJob = qobject_cast<KIO::StoredTransferJob *>(job)) {
-        QImage image;
+    }
 
-        // TODO make proper caching calls
-        QString path = m_filename;
-        qDebug() << "Saving download to" << path;
+    if (!errorMessage.isEmpty()) {
+        QFile::remove(partFile);
+        qCritical() << errorMessage;
+    }
 
-        image.loadFromData(transferJob->data());
-        image.save(path);
+    // a download ahead of time, nobody is waiting for it yet
+    if (path != m_pendingPath) {
+        return;
+    }
+    m_pendingPath.clear();
 
-        qDebug() << "Saved to" << path;
+    QJSValueList args;
 
+    if (errorMessage.isEmpty()) {
         if(m_successCallback.isCallable()) {
-            args << QJSValue(path);
+            args << QJSValue(cachedFile);
             m_successCallback.call(args);
         }
-    }
-    else {
-        errorMessage = QStringLiteral("Unknown error occurred");
-
-        qCritical() << errorMessage;
-
+    } else {
         if(m_errorCallback.isCallable()) {
             args << QJSValue(errorMessage);
             m_errorCallback.call(args);
         }
     }
 }
+
+#include "mediaframe.moc"
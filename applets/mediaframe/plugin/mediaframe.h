@@ -25,6 +25,13 @@
 #include <QHash>
 #include <QFileSystemWatcher>
 #include <QJSValue>
+#include <QSet>
+#include <QSharedPointer>
+#include <QSize>
+#include <QThreadPool>
+#include <QTimer>
+
+#include <atomic>
 
 #include <KIO/Job>
 
@@ -36,6 +43,7 @@ class MediaFrame : public QObject
     Q_PROPERTY(int historyLength READ historyLength NOTIFY historyLengthChanged)
     Q_PROPERTY(int futureLength READ futureLength NOTIFY futureLengthChanged)
     Q_PROPERTY(bool random READ random WRITE setRandom NOTIFY randomChanged)
+    Q_PROPERTY(QSize imageSize READ imageSize WRITE setImageSize NOTIFY imageSizeChanged)
 
     public:
 
@@ -57,6 +65,10 @@ class MediaFrame : public QObject
         bool random() const;
         void setRandom(bool random);
 
+        // the size the upcoming images are decoded at, see MediaFrameImageProvider
+        QSize imageSize() const;
+        void setImageSize(const QSize &size);
+
         Q_INVOKABLE bool isDir(const QString &path);
         Q_INVOKABLE bool isDirEmpty(const QString &path);
         Q_INVOKABLE bool isFile(const QString &path);
@@ -67,6 +79,8 @@ class MediaFrame : public QObject
 
         Q_INVOKABLE void watch(const QString &path);
 
+        Q_INVOKABLE QString imageSource(const QString &path);
+
         Q_INVOKABLE bool isAdded(const QString &path);
 
         Q_INVOKABLE void get(QJSValue callback);
@@ -83,31 +97,81 @@ class MediaFrame : public QObject
         void historyLengthChanged();
         void futureLengthChanged();
         void randomChanged();
+        void imageSizeChanged();
         void itemChanged(const QString &path);
 
     private Q_SLOTS:
         void slotItemChanged(const QString &path);
         void slotFinished(KJob *job);
+        void slotFilesFound(quint64 scan, const QString &path, const QStringList &files);
+        void slotScanFinished(quint64 scan, const QString &path, const QStringList &directories);
+        void slotDirectoryChanged(const QString &directory);
+        void slotRescan();
 
     private:
+        void scan(const QString &path, bool refresh);
+        void cancelScans();
+        void watchDirectories(const QString &path, const QStringList &directories);
+        void countChangedLater();
+
         int random(int min, int max);
         QString getCacheDirectory();
         QString hash(const QString &str);
+        QString cachedPath(const QString &path);
+        bool isRemote(const QString &path);
+        QStringList upcoming();
+        void readAhead();
+        void preloadUpcoming();
+        void download(const QString &path);
+        void trimCache();
 
         QStringList m_filters;
         QHash<QString, QStringList> m_pathMap;
+        // the added paths, in the order their files are shown
+        QStringList m_paths;
         QStringList m_allFiles;
         QString m_watchFile;
         QFileSystemWatcher m_watcher;
 
+        // directories are walked in the background, reporting their files in batches
+        QThreadPool m_scanPool;
+        struct ScanRoot {
+            QString localPath;
+            bool recursive;
+        };
+        QHash<QString, ScanRoot> m_scanRoots;
+        struct Scan {
+            quint64 id;
+            QSharedPointer<std::atomic<bool>> cancelled;
+            // a rescan of an added directory collects its files to replace the current ones
+            bool refresh;
+            QStringList files;
+        };
+        QHash<QString, Scan> m_scans;
+        quint64 m_nextScanId = 0;
+        QTimer m_countChangedTimer;
+
+        // every scanned directory is watched, mapping to the added paths it belongs to
+        QFileSystemWatcher m_directoryWatcher;
+        QHash<QString, QStringList> m_watchedDirectories;
+        QSet<QString> m_changedPaths;
+        QTimer m_rescanTimer;
+
         QStringList m_history;
         QStringList m_future;
 
+        // remote items are downloaded into the cache ahead of being shown
+        QHash<QString, KJob *> m_downloads;
+        // random picks are made ahead as well, so they can be downloaded
+        QStringList m_upcoming;
+
+        // the remote item get() is waiting for
+        QString m_pendingPath;
         QJSValue m_successCallback;
         QJSValue m_errorCallback;
-        QString m_filename;
 
         bool m_random = false;
+        QSize m_imageSize;
         int m_next = 0;
 };
 
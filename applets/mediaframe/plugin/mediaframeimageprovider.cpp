@@ -0,0 +1,258 @@
+/*
+ *  Copyright 2020 Lars Pontoppidan <dev.larpon@gmail.com>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  2.010-1301, USA.
+ */
+
+#include "mediaframeimageprovider.h"
+
+#include <QDebug>
+#include <QImageReader>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QUrl>
+
+namespace {
+
+// the one shown and the ones coming up, pictures preloaded but never requested
+// because the frame got resized are dropped soon as well
+const int s_maxPictures = 3;
+
+QImage decode(const QString &path, const QSize &size)
+{
+    const QUrl url(path);
+    QImageReader reader(url.isLocalFile() ? url.toLocalFile() : path);
+    reader.setAutoTransform(true);
+
+    // the scaled size applies before the image gets rotated according to its metadata
+    const bool transposed = reader.transformation() & QImageIOHandler::TransformationRotate90;
+    QSize imageSize = reader.size();
+    if (transposed) {
+        imageSize.transpose();
+    }
+
+    if (!imageSize.isEmpty()) {
+        // cover the requested size, the item may crop the picture to fill itself
+        const qreal widthScale = size.width() > 0 ? qreal(size.width()) / imageSize.width() : 0;
+        const qreal heightScale = size.height() > 0 ? qreal(size.height()) / imageSize.height() : 0;
+        const qreal scale = qMax(widthScale, heightScale);
+        if (scale > 0 && scale < 1) {
+            QSize scaledSize = (QSizeF(imageSize) * scale).toSize().expandedTo(QSize(1, 1));
+            if (transposed) {
+                scaledSize.transpose();
+            }
+            reader.setScaledSize(scaledSize);
+        }
+    }
+
+    const QImage image = reader.read();
+    if (image.isNull()) {
+        qWarning() << "Error reading image" << path << reader.errorString();
+    }
+    return image;
+}
+
+class MediaFrameImageResponse : public QQuickImageResponse
+{
+    Q_OBJECT
+
+public:
+    explicit MediaFrameImageResponse(const QString &path)
+        : m_path(path)
+    {
+    }
+
+    QQuickTextureFactory *textureFactory() const override
+    {
+        return QQuickTextureFactory::textureFactoryForImage(m_image);
+    }
+
+    QString errorString() const override
+    {
+        return m_image.isNull() ? QStringLiteral("Error reading image %1").arg(m_path) : QString();
+    }
+
+public Q_SLOTS:
+    void setImage(const QImage &image)
+    {
+        m_image = image;
+        emit finished();
+    }
+
+private:
+    const QString m_path;
+    QImage m_image;
+};
+
+/**
+ * Hands the decoded picture to the response, which QML may have deleted in the meantime.
+ */
+class DecodeJob : public QObject, public QRunnable
+{
+    Q_OBJECT
+
+public:
+    DecodeJob(MediaFrameImageProvider *provider, const QString &path, const QSize &size)
+        : m_provider(provider)
+        , m_path(path)
+        , m_size(size)
+    {
+    }
+
+    void run() override
+    {
+        emit decoded(m_provider->image(m_path, m_size));
+    }
+
+Q_SIGNALS:
+    void decoded(const QImage &image);
+
+private:
+    MediaFrameImageProvider *const m_provider;
+    const QString m_path;
+    const QSize m_size;
+};
+
+}
+
+class DecodeAheadJob : public QRunnable
+{
+public:
+    DecodeAheadJob(MediaFrameImageProvider *provider, const QSharedPointer<MediaFrameImageProvider::Picture> &picture)
+        : m_provider(provider)
+        , m_picture(picture)
+    {
+    }
+
+    void run() override
+    {
+        m_provider->decodeAhead(m_picture);
+    }
+
+private:
+    MediaFrameImageProvider *const m_provider;
+    const QSharedPointer<MediaFrameImageProvider::Picture> m_picture;
+};
+
+MediaFrameImageProvider::MediaFrameImageProvider()
+{
+    // one picture shown, one coming up
+    m_pool.setMaxThreadCount(2);
+}
+
+MediaFrameImageProvider::~MediaFrameImageProvider()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_pictures.clear();
+    }
+    m_pool.waitForDone();
+}
+
+QString MediaFrameImageProvider::name()
+{
+    return QStringLiteral("mediaframe");
+}
+
+QString MediaFrameImageProvider::source(const QString &path)
+{
+    if (path.isEmpty()) {
+        return QString();
+    }
+    return QLatin1String("image://") + name() + QLatin1Char('/') + QString::fromLatin1(QUrl::toPercentEncoding(path));
+}
+
+QQuickImageResponse *MediaFrameImageProvider::requestImageResponse(const QString &id, const QSize &requestedSize)
+{
+    const QString path = QUrl::fromPercentEncoding(id.toUtf8());
+
+    auto *response = new MediaFrameImageResponse(path);
+    auto *job = new DecodeJob(this, path, requestedSize);
+    QObject::connect(job, &DecodeJob::decoded, response, &MediaFrameImageResponse::setImage);
+    m_pool.start(job);
+    return response;
+}
+
+QSharedPointer<MediaFrameImageProvider::Picture> MediaFrameImageProvider::picture(const QString &path, const QSize &size)
+{
+    for (const auto &picture : qAsConst(m_pictures)) {
+        if (picture->path == path && picture->size == size) {
+            return picture;
+        }
+    }
+
+    QSharedPointer<Picture> picture(new Picture);
+    picture->path = path;
+    picture->size = size;
+    picture->state = Picture::Queued;
+    m_pictures.append(picture);
+    while (m_pictures.count() > s_maxPictures) {
+        m_pictures.removeFirst();
+    }
+    return picture;
+}
+
+void MediaFrameImageProvider::preload(const QString &path, const QSize &size)
+{
+    QMutexLocker locker(&m_mutex);
+    const QSharedPointer<Picture> picture = this->picture(path, size);
+    if (picture->state == Picture::Queued) {
+        m_pool.start(new DecodeAheadJob(this, picture));
+    }
+}
+
+void MediaFrameImageProvider::decodeAhead(const QSharedPointer<Picture> &picture)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        // dropped already, or being decoded for a request
+        if (picture->state != Picture::Queued || !m_pictures.contains(picture)) {
+            return;
+        }
+        picture->state = Picture::Decoding;
+    }
+
+    const QImage decoded = decode(picture->path, picture->size);
+
+    QMutexLocker locker(&m_mutex);
+    picture->image = decoded;
+    picture->state = Picture::Done;
+    m_decoded.wakeAll();
+}
+
+QImage MediaFrameImageProvider::image(const QString &path, const QSize &size)
+{
+    QMutexLocker locker(&m_mutex);
+    const QSharedPointer<Picture> picture = this->picture(path, size);
+
+    if (picture->state == Picture::Queued) {
+        // not preloaded, or its job didn't get a thread yet, this one is as good as any
+        picture->state = Picture::Decoding;
+        locker.unlock();
+        const QImage decoded = decode(path, size);
+        locker.relock();
+        picture->image = decoded;
+        picture->state = Picture::Done;
+        m_decoded.wakeAll();
+        return decoded;
+    }
+
+    while (picture->state != Picture::Done) {
+        m_decoded.wait(&m_mutex);
+    }
+    return picture->image;
+}
+
+#include "mediaframeimageprovider.moc"
@@ -0,0 +1,89 @@
+/*
+ *  Copyright 2020 Lars Pontoppidan <dev.larpon@gmail.com>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  2.010-1301, USA.
+ */
+
+#ifndef MEDIAFRAMEIMAGEPROVIDER_H
+#define MEDIAFRAMEIMAGEPROVIDER_H
+
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QQuickAsyncImageProvider>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+/**
+ * Decodes the pictures of the media frames on worker threads, at the size they are shown at.
+ *
+ * Full resolution photos are never decoded as a whole, QImageReader scales them down
+ * while reading. MediaFrame preloads the upcoming pictures, so they are usually ready
+ * by the time the frame switches.
+ */
+class MediaFrameImageProvider : public QQuickAsyncImageProvider
+{
+public:
+    MediaFrameImageProvider();
+    ~MediaFrameImageProvider() override;
+
+    static QString name();
+
+    /**
+     * The Image source showing @p path through the provider, empty for an empty @p path.
+     */
+    static QString source(const QString &path);
+
+    QQuickImageResponse *requestImageResponse(const QString &id, const QSize &requestedSize) override;
+
+    /**
+     * Starts decoding @p path at @p size ahead of it being requested.
+     */
+    void preload(const QString &path, const QSize &size);
+
+    /**
+     * The picture @p path decoded at @p size. The last few pictures are kept, since
+     * the transition and the front image of a frame request each of them in turn.
+     * Blocks, so this is for the worker threads only.
+     */
+    QImage image(const QString &path, const QSize &size);
+
+private:
+    struct Picture {
+        enum State {
+            Queued,
+            Decoding,
+            Done,
+        };
+
+        QString path;
+        QSize size;
+        State state;
+        QImage image;
+    };
+
+    // with m_mutex locked
+    QSharedPointer<Picture> picture(const QString &path, const QSize &size);
+    void decodeAhead(const QSharedPointer<Picture> &picture);
+    friend class DecodeAheadJob;
+
+    QMutex m_mutex;
+    QWaitCondition m_decoded;
+    QList<QSharedPointer<Picture>> m_pictures;
+    QThreadPool m_pool;
+};
+
+#endif
@@ -0,0 +1,164 @@
+/*
+ *  Copyright 2020 Lars Pontoppidan <dev.larpon@gmail.com>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  2.010-1301, USA.
+ */
+
+#include "mediaframeindex.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace {
+
+const quint32 s_magic = 0x4d464931; // "MFI1"
+
+// listings of directories no frame looked at for this long are dropped
+const qint64 s_maxUnusedMSecs = 30 * 24 * 60 * 60 * 1000LL;
+
+// a directory changing again within the same tick of its modification time would go
+// unnoticed, so listings of directories modified this recently are not trusted
+const qint64 s_settleMSecs = 2000;
+
+}
+
+MediaFrameIndex &MediaFrameIndex::instance()
+{
+    static MediaFrameIndex index;
+    return index;
+}
+
+MediaFrameIndex::MediaFrameIndex()
+    // not the application's cache location, the index is shared with the remote media cache
+    : m_fileName(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/plasma_mediaframe/index"))
+{
+    load();
+}
+
+MediaFrameIndex::Directory MediaFrameIndex::directory(const QString &path, const QStringList &filters)
+{
+    const QFileInfo info(path);
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const qint64 modified = info.lastModified().toMSecsSinceEpoch();
+
+    {
+        QMutexLocker locker(&m_mutex);
+        if (filters != m_filters) {
+            // other image formats are supported now, every listing is incomplete
+            m_entries.clear();
+            m_filters = filters;
+            m_dirty = true;
+        }
+        if (!info.isDir()) {
+            m_dirty = m_entries.remove(path) > 0 || m_dirty;
+            return Directory();
+        }
+        auto it = m_entries.find(path);
+        if (it != m_entries.end() && it->modified == modified) {
+            // only worth a write once a day
+            if (now - it->used > 24 * 60 * 60 * 1000LL) {
+                it->used = now;
+                m_dirty = true;
+            }
+            return it->directory;
+        }
+    }
+
+    const QDir dir(path);
+    Directory directory;
+    directory.files = dir.entryList(filters, QDir::Files, QDir::Name);
+    directory.subdirectories = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+
+    QMutexLocker locker(&m_mutex);
+    if (now - modified < s_settleMSecs) {
+        m_dirty = m_entries.remove(path) > 0 || m_dirty;
+    } else {
+        m_entries.insert(path, Entry{modified, now, directory});
+        m_dirty = true;
+    }
+    return directory;
+}
+
+void MediaFrameIndex::load()
+{
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+
+    quint32 magic;
+    QStringList filters;
+    qint32 count;
+    stream >> magic;
+    if (stream.status() != QDataStream::Ok || magic != s_magic) {
+        return;
+    }
+    stream >> filters >> count;
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QHash<QString, Entry> entries;
+    entries.reserve(qMax(count, 0));
+    for (qint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString path;
+        Entry entry;
+        stream >> path >> entry.modified >> entry.used >> entry.directory.files >> entry.directory.subdirectories;
+        if (now - entry.used < s_maxUnusedMSecs) {
+            entries.insert(path, entry);
+        }
+    }
+    if (stream.status() != QDataStream::Ok) {
+        qWarning() << "Ignoring corrupt media frame index" << m_fileName;
+        return;
+    }
+
+    m_filters = filters;
+    m_entries = entries;
+    m_dirty = entries.count() != count;
+}
+
+void MediaFrameIndex::save()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_dirty) {
+        return;
+    }
+
+    QDir().mkpath(QFileInfo(m_fileName).path());
+    QSaveFile file(m_fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Can't write media frame index" << m_fileName << file.errorString();
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+    stream << s_magic << m_filters << qint32(m_entries.count());
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        stream << it.key() << it->modified << it->used << it->directory.files << it->directory.subdirectories;
+    }
+    if (file.commit()) {
+        m_dirty = false;
+    }
+}
@@ -0,0 +1,73 @@
+/*
+ *  Copyright 2020 Lars Pontoppidan <dev.larpon@gmail.com>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  2.010-1301, USA.
+ */
+
+#ifndef MEDIAFRAMEINDEX_H
+#define MEDIAFRAMEINDEX_H
+
+#include <QHash>
+#include <QMutex>
+#include <QStringList>
+
+/**
+ * Listings of the directories scanned by the media frames, kept on disk.
+ *
+ * A listing is reused for as long as the modification time of its directory
+ * stays the same, so only directories which changed have to be read again.
+ * The index is shared by all media frames of a process and may be used from
+ * any thread.
+ */
+class MediaFrameIndex
+{
+public:
+    struct Directory {
+        QStringList files;
+        QStringList subdirectories;
+    };
+
+    static MediaFrameIndex &instance();
+
+    /**
+     * The media files and subdirectories of @p path, names only.
+     * @p filters are the name filters media files have to match.
+     */
+    Directory directory(const QString &path, const QStringList &filters);
+
+    /**
+     * Writes the index back to disk, if any listing changed since it was read.
+     */
+    void save();
+
+private:
+    MediaFrameIndex();
+
+    struct Entry {
+        qint64 modified;
+        qint64 used;
+        Directory directory;
+    };
+
+    void load();
+
+    const QString m_fileName;
+    QMutex m_mutex;
+    QStringList m_filters;
+    QHash<QString, Entry> m_entries;
+    bool m_dirty = false;
+};
+
+#endif
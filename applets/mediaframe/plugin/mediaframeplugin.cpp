@@ -18,10 +18,19 @@
 
 #include "mediaframeplugin.h"
 #include "mediaframe.h"
+#include "mediaframeimageprovider.h"
 
 // Qt
 #include <QQmlEngine>
 
+void MediaFramePlugin::initializeEngine(QQmlEngine *engine, const char *uri)
+{
+    Q_UNUSED(uri);
+
+    // the engine takes ownership
+    engine->addImageProvider(MediaFrameImageProvider::name(), new MediaFrameImageProvider);
+}
+
 void MediaFramePlugin::registerTypes(const char *uri)
 {
     Q_ASSERT(QLatin1String(uri) == QLatin1String("org.kde.plasma.private.mediaframe"));
@@ -28,6 +28,7 @@ class MediaFramePlugin : public QQmlExtensionPlugin
     Q_PLUGIN_METADATA(IID "org.qt-project.Qt.QQmlExtensionInterface")
 
     public:
+        void initializeEngine(QQmlEngine *engine, const char *uri) override;
         void registerTypes(const char *uri) override;
 };
 
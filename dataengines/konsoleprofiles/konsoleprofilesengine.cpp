@@ -17,21 +17,16 @@
 *****************************************************************************/
 
 #include "konsoleprofilesengine.h"
+#include "konsoleprofileindex.h"
 #include "konsoleprofilesservice.h"
 
-// KF
-#include <KDirWatch>
-#include <KConfig>
 // Qt
-#include <QFileInfo>
-#include <QDir>
-#include <QStandardPaths>
 #include <QDebug>
 
 
 KonsoleProfilesEngine::KonsoleProfilesEngine(QObject *parent, const QVariantList &args)
     : Plasma::DataEngine(parent, args),
-      m_dirWatch(nullptr)
+      m_profileIndex(nullptr)
 {
     init();
 }
@@ -44,14 +39,13 @@ void KonsoleProfilesEngine::init()
 {
     qDebug() << "KonsoleProfilesDataEngine init";
 
-    m_dirWatch = new KDirWatch( this );
-    const QStringList konsoleDataBaseDirs = QStandardPaths::standardLocations(QStandardPaths::GenericDataLocation);
-    for (const QString& konsoleDataBaseDir : konsoleDataBaseDirs) {
-        m_dirWatch->addDir(konsoleDataBaseDir + QLatin1String("/konsole"));
-    }
-    connect(m_dirWatch, &KDirWatch::dirty, this, &KonsoleProfilesEngine::profilesChanged);
+    // only the sources of profiles which changed are touched, the others keep their connected visualizations undisturbed
+    m_profileIndex = new KonsoleProfileIndex(this);
+    connect(m_profileIndex, &KonsoleProfileIndex::profileAdded, this, &KonsoleProfilesEngine::setProfile);
+    connect(m_profileIndex, &KonsoleProfileIndex::profileChanged, this, &KonsoleProfilesEngine::setProfile);
+    connect(m_profileIndex, &KonsoleProfileIndex::profileRemoved, this, &KonsoleProfilesEngine::removeSource);
 
-    loadProfiles();
+    m_profileIndex->update();
 }
 
 Plasma::Service *KonsoleProfilesEngine::serviceForSource(const QString &source)
@@ -60,42 +54,10 @@ Plasma::Service *KonsoleProfilesEngine::serviceForSource(const QString &source)
     return new KonsoleProfilesService(this, source);
 }
 
-void KonsoleProfilesEngine::profilesChanged()
+void KonsoleProfilesEngine::setProfile(const KonsoleProfile &profile)
 {
-    //wipe the data clean, load it again. (there's not a better way of doing this but no big deal)
-    removeAllSources();
-    loadProfiles();
-}
-
-void KonsoleProfilesEngine::loadProfiles()
-{
-    QStringList profilesPaths;
-    const QStringList dirs = QStandardPaths::locateAll(QStandardPaths::GenericDataLocation, QStringLiteral("konsole"), QStandardPaths::LocateDirectory);
-
-    for (const auto& dir : dirs) {
-        const QStringList fileNames = QDir(dir).entryList({QStringLiteral("*.profile")});
-        for (const QString& fileName : fileNames) {
-            profilesPaths.append(dir + QLatin1Char('/') + fileName);
-        }
-    }
-
-    for (const auto& profilePath : qAsConst(profilesPaths)) {
-        QFileInfo info(profilePath);
-        const QString profileName = info.baseName();
-        QString niceName = profileName;
-        KConfig cfg(profilePath, KConfig::SimpleConfig);
-
-        if ( cfg.hasGroup( "General" ) ) {
-            KConfigGroup grp( &cfg, "General" );
-
-            if ( grp.hasKey( "Name" ) ) {
-                niceName = grp.readEntry( "Name" );
-            }
-
-            qDebug() << "adding sourcename: " << profileName << " ++" << niceName;
-            setData(profileName, QStringLiteral("prettyName"), niceName);
-        }
-    }
+    qDebug() << "setting sourcename: " << profile.name << " ++" << profile.displayName;
+    setData(profile.name, QStringLiteral("prettyName"), profile.displayName);
 }
 
 K_EXPORT_PLASMA_DATAENGINE_WITH_JSON(konsoleprofilesengine, KonsoleProfilesEngine, "plasma-dataengine-konsoleprofiles.json")
@@ -21,7 +21,8 @@
 
 #include <Plasma/DataEngine>
 
-class KDirWatch;
+class KonsoleProfileIndex;
+struct KonsoleProfile;
 
 class KonsoleProfilesEngine : public Plasma::DataEngine
 {
@@ -34,13 +35,10 @@ public:
     void init();
     Plasma::Service *serviceForSource(const QString &source) override;
 
-private Q_SLOTS:
-    void profilesChanged();
-
 private:
-    void loadProfiles();
+    void setProfile(const KonsoleProfile &profile);
 
-    KDirWatch *m_dirWatch;
+    KonsoleProfileIndex *m_profileIndex;
 };
 
 #endif
@@ -20,61 +20,26 @@
 
 #include "apodprovider.h"
 
-#include <QRegExp>
 #include <QDebug>
 
 #include <KPluginFactory>
-#include <KIO/Job>
 
 ApodProvider::ApodProvider(QObject *parent, const QVariantList &args)
     : PotdProvider(parent, args)
 {
     const  QUrl url(QStringLiteral("http://antwrp.gsfc.nasa.gov/apod/"));
 
-    KIO::StoredTransferJob *job = KIO::storedGet(url, KIO::NoReload, KIO::HideProgressInfo);
-    connect(job, &KIO::StoredTransferJob::finished, this, &ApodProvider::pageRequestFinished);
+    findPageLink(url, QByteArrayLiteral("<a href=\"image/"), QByteArrayLiteral("\""), [this](const QByteArray &link) {
+        pageLinkFound(link);
+    });
 }
 
 ApodProvider::~ApodProvider() = default;
 
-QImage ApodProvider::image() const
+void ApodProvider::pageLinkFound(const QByteArray &link)
 {
-    return mImage;
-}
-
-void ApodProvider::pageRequestFinished(KJob *_job)
-{
-    KIO::StoredTransferJob *job = static_cast<KIO::StoredTransferJob *>( _job );
-    if ( job->error() ) {
-        emit error(this);
-        return;
-    }
-
-    const QString data = QString::fromUtf8( job->data() );
-
-    const QString pattern = QStringLiteral("<a href=\"(image/.*)\"" );
-    QRegExp exp( pattern );
-    exp.setMinimal( true );
-    if ( exp.indexIn( data ) != -1 ) {
-        const QString sub = exp.cap(1);
-        const QUrl url(QLatin1String("http://antwrp.gsfc.nasa.gov/apod/") + sub);
-        KIO::StoredTransferJob *imageJob = KIO::storedGet( url, KIO::NoReload, KIO::HideProgressInfo );
-        connect(imageJob, &KIO::StoredTransferJob::finished, this, &ApodProvider::imageRequestFinished);
-    } else {
-        emit error(this);
-    }
-}
-
-void ApodProvider::imageRequestFinished(KJob *_job)
-{
-    KIO::StoredTransferJob *job = static_cast<KIO::StoredTransferJob *>( _job );
-    if ( job->error() ) {
-	emit error(this);
-	return;
-    }
-
-    mImage = QImage::fromData( job->data() );
-    emit finished(this);
+    const QUrl url(QLatin1String("http://antwrp.gsfc.nasa.gov/apod/image/") + QString::fromUtf8(link));
+    requestImage(url);
 }
 
 K_PLUGIN_CLASS_WITH_JSON(ApodProvider, "apodprovider.json")
@@ -23,10 +23,6 @@
 
 #include "potdprovider.h"
 
-#include <QImage>
-
-class KJob;
-
 /**
  * This class provides the image for APOD 
  * "Astronomy Picture Of the Day"
@@ -54,20 +50,8 @@ class ApodProvider : public PotdProvider
          */
         ~ApodProvider() override;
 
-        /**
-         * Returns the requested image.
-         *
-         * Note: This method returns only a valid image after the
-         *       finished() signal has been emitted.
-         */
-        QImage image() const override;
-
-    private:
-        void pageRequestFinished(KJob *job);
-        void imageRequestFinished(KJob *job);
-
     private:
-        QImage mImage;
+        void pageLinkFound(const QByteArray &link);
 };
 
 #endif
@@ -0,0 +1,393 @@
+/*
+ *   Copyright 2020 Guo Yunhe <i@guoyunhe.me>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include <QImageWriter>
+#include <QSettings>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTest>
+#include <QTimer>
+#include <QUrl>
+
+#include <Plasma/DataEngine>
+#include <Plasma/DataEngineConsumer>
+
+
+namespace {
+// the stand-in server sends bodies in slices like this, roughly 12 MiB/s,
+// so aborting a transfer early shows up in the bytes sent
+const int s_chunkSize = 64 * 1024;
+const int s_chunkInterval = 5;
+// recorded pages are cut after the part the providers look at, pad them back to a realistic size
+const int s_pageSize = 256 * 1024;
+
+// a line like "VmHWM:   123456 kB" of /proc/self/status, in KiB, or -1 where there is none
+qint64 memoryStatus(const QByteArray &field)
+{
+    QFile status(QStringLiteral("/proc/self/status"));
+    if (!status.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+    const QList<QByteArray> lines = status.readAll().split('\n');
+    for (const QByteArray &line : lines) {
+        if (line.startsWith(field + ':')) {
+            return line.mid(field.size() + 1).simplified().split(' ').value(0).toLongLong();
+        }
+    }
+    return -1;
+}
+
+// the high-water mark of the process otherwise only grows, Linux lets it start over
+// at the current resident size, so the peak of each provider is seen on its own
+void resetPeakRss()
+{
+    QFile clearRefs(QStringLiteral("/proc/self/clear_refs"));
+    if (clearRefs.open(QIODevice::WriteOnly)) {
+        clearRefs.write("5");
+    }
+}
+}
+
+/**
+ * Serves canned responses for the hosts of the providers, which reach it
+ * through PLASMA_POTD_TEST_SERVER, and accounts for what it sends.
+ */
+class StandInServer : public QTcpServer
+{
+    Q_OBJECT
+
+public:
+    void addRoute(const QByteArray &path, const QByteArray &body, const QByteArray &contentType)
+    {
+        m_routes.insert(path, qMakePair(body, contentType));
+    }
+
+    void resetStatistics()
+    {
+        m_clock.start();
+        m_firstByte = -1;
+        m_lastByte = -1;
+        m_bytesSent = 0;
+        m_requests = 0;
+        m_notModified = 0;
+        m_unknownPaths.clear();
+    }
+
+    qint64 firstByte() const { return m_firstByte; }
+    qint64 lastByte() const { return m_lastByte; }
+    qint64 bytesSent() const { return m_bytesSent; }
+    int requests() const { return m_requests; }
+    int notModified() const { return m_notModified; }
+    QList<QByteArray> unknownPaths() const { return m_unknownPaths; }
+
+protected:
+    void incomingConnection(qintptr handle) override
+    {
+        auto socket = new QTcpSocket(this);
+        socket->setSocketDescriptor(handle);
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket] {
+            handleRequest(socket);
+        });
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+    }
+
+private:
+    void handleRequest(QTcpSocket *socket)
+    {
+        QByteArray &request = m_pending[socket];
+        request += socket->readAll();
+        const int headerEnd = request.indexOf("\r\n\r\n");
+        if (headerEnd < 0) {
+            return;
+        }
+
+        const QList<QByteArray> lines = request.left(headerEnd).split('\n');
+        m_pending.remove(socket);
+
+        const QByteArray target = lines.value(0).trimmed().split(' ').value(1);
+        const QByteArray path = QUrl::fromPercentEncoding(target.left(target.indexOf('?'))).toUtf8();
+        QByteArray ifNoneMatch;
+        for (const QByteArray &line : lines) {
+            if (line.toLower().startsWith("if-none-match:")) {
+                ifNoneMatch = line.mid(14).trimmed();
+            }
+        }
+
+        ++m_requests;
+        if (m_firstByte < 0) {
+            m_firstByte = m_clock.elapsed();
+        }
+
+        if (!m_routes.contains(path)) {
+            m_unknownPaths << path;
+            socket->write("HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+            socket->disconnectFromHost();
+            return;
+        }
+
+        const QByteArray body = m_routes.value(path).first;
+        const QByteArray eTag = '"' + QCryptographicHash::hash(body, QCryptographicHash::Md5).toHex() + '"';
+        if (ifNoneMatch == eTag) {
+            ++m_notModified;
+            socket->write("HTTP/1.1 304 Not Modified\r\nETag: " + eTag + "\r\nConnection: close\r\n\r\n");
+            socket->disconnectFromHost();
+            return;
+        }
+
+        socket->write("HTTP/1.1 200 OK\r\nContent-Type: " + m_routes.value(path).second
+                      + "\r\nContent-Length: " + QByteArray::number(body.size())
+                      + "\r\nETag: " + eTag
+                      + "\r\nConnection: close\r\n\r\n");
+
+        auto timer = new QTimer(socket);
+        timer->setInterval(s_chunkInterval);
+        connect(timer, &QTimer::timeout, socket, [this, socket, timer, body] {
+            const int offset = timer->property("offset").toInt();
+            if (socket->state() != QAbstractSocket::ConnectedState) {
+                timer->stop();
+                return;
+            }
+            const QByteArray chunk = body.mid(offset, s_chunkSize);
+            socket->write(chunk);
+            m_bytesSent += chunk.size();
+            m_lastByte = m_clock.elapsed();
+            timer->setProperty("offset", offset + chunk.size());
+            if (offset + chunk.size() >= body.size()) {
+                timer->stop();
+                socket->disconnectFromHost();
+            }
+        });
+        timer->start();
+    }
+
+    QHash<QByteArray, QPair<QByteArray, QByteArray>> m_routes;
+    QHash<QTcpSocket *, QByteArray> m_pending;
+    QElapsedTimer m_clock;
+    qint64 m_firstByte = -1;
+    qint64 m_lastByte = -1;
+    qint64 m_bytesSent = 0;
+    int m_requests = 0;
+    int m_notModified = 0;
+    QList<QByteArray> m_unknownPaths;
+};
+
+class ImageWatcher : public QObject
+{
+    Q_OBJECT
+
+public Q_SLOTS:
+    void dataUpdated(const QString &source, const Plasma::DataEngine::Data &data)
+    {
+        const QImage image = data.value(QStringLiteral("Image")).value<QImage>();
+        if (!image.isNull()) {
+            emit imageReady(source, image);
+        }
+    }
+
+Q_SIGNALS:
+    void imageReady(const QString &source, const QImage &image);
+};
+
+class PotdEngineTest : public QObject, public Plasma::DataEngineConsumer
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanup();
+
+    void testFetch_data();
+    void testFetch();
+    void testConditionalRefresh();
+
+private:
+    QByteArray fixture(const QString &fileName, int paddedSize = 0) const;
+
+    StandInServer m_server;
+    QByteArray m_image;
+    Plasma::DataEngine *m_engine = nullptr;
+    ImageWatcher m_watcher;
+};
+
+QByteArray PotdEngineTest::fixture(const QString &fileName, int paddedSize) const
+{
+    QFile file(QFINDTESTDATA(QStringLiteral("data/") + fileName));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    QByteArray data = file.readAll();
+    if (data.size() < paddedSize) {
+        data += "<!--";
+        data += QByteArray(qMax(0, paddedSize - data.size() - 4), 'x');
+        data += "-->";
+    }
+    return data;
+}
+
+void PotdEngineTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QLatin1String("/plasma_engine_potd/")).removeRecursively();
+
+    // the plugins of this build take precedence over installed ones
+    QCoreApplication::addLibraryPath(QCoreApplication::applicationDirPath());
+
+    QVERIFY(QImageWriter::supportedImageFormats().contains("jpeg"));
+    QImage image(3840, 2160, QImage::Format_RGB32);
+    for (int y = 0; y < image.height(); ++y) {
+        QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            line[x] = qRgb(x % 256, y % 256, (x + y) % 256);
+        }
+    }
+    QBuffer buffer(&m_image);
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(image.save(&buffer, "JPEG", 90));
+
+    m_server.addRoute("/antwrp.gsfc.nasa.gov/apod/", fixture(QStringLiteral("apod.html"), s_pageSize), "text/html");
+    m_server.addRoute("/antwrp.gsfc.nasa.gov/apod/image/2006/standin_apod.jpg", m_image, "image/jpeg");
+    m_server.addRoute("/www.bing.com/HPImageArchive.aspx", fixture(QStringLiteral("bing.json")), "application/json");
+    m_server.addRoute("/www.bing.com//th", m_image, "image/jpeg");
+    m_server.addRoute("/epod.usra.edu/blog/", fixture(QStringLiteral("epod.html"), s_pageSize), "text/html");
+    m_server.addRoute("/epod.usra.edu/.a/6a0105371bb32c970b0282e12d0ef6200b-pi", m_image, "image/jpeg");
+    m_server.addRoute("/api.flickr.com/services/rest/", fixture(QStringLiteral("flickr.xml")), "text/xml");
+    m_server.addRoute("/live.staticflickr.com/65535/49999999999_standin_k.jpg", m_image, "image/jpeg");
+    m_server.addRoute("/www.nationalgeographic.com/photography/photo-of-the-day/", fixture(QStringLiteral("natgeo.html"), s_pageSize), "text/html");
+    m_server.addRoute("/www.nationalgeographic.com/content/dam/photography/photo-of-the-day/2020/06/standin.jpg", m_image, "image/jpeg");
+    m_server.addRoute("/www.nesdis.noaa.gov/content/imagery-and-data", fixture(QStringLiteral("noaa.html"), s_pageSize), "text/html");
+    m_server.addRoute("/www.nesdis.noaa.gov/sites/default/files/standin_imagery.jpg", m_image, "image/jpeg");
+    m_server.addRoute("/source.unsplash.com/collection/1065976/3840x2160/daily", m_image, "image/jpeg");
+    m_server.addRoute("/commons.wikimedia.org/w/api.php", fixture(QStringLiteral("wcpotd.json")), "application/json");
+    m_server.addRoute("/commons.wikimedia.org/wiki/Special:FilePath/Stand-in_picture_of_the_day.jpg", m_image, "image/jpeg");
+
+    QVERIFY(m_server.listen(QHostAddress::LocalHost));
+    qputenv("PLASMA_POTD_TEST_SERVER", QByteArrayLiteral("http://127.0.0.1:") + QByteArray::number(m_server.serverPort()));
+
+    m_engine = dataEngine(QStringLiteral("potd"));
+    QVERIFY(m_engine && m_engine->isValid());
+
+    const QVariantMap providers = m_engine->containerForSource(QStringLiteral("Providers"))->data();
+    for (const char *provider : {"apod", "bing", "epod", "flickr", "natgeo", "noaa", "unsplash", "wcpotd"}) {
+        QVERIFY2(providers.contains(QLatin1String(provider)), provider);
+    }
+}
+
+void PotdEngineTest::cleanup()
+{
+    QVERIFY(m_server.unknownPaths().isEmpty());
+}
+
+void PotdEngineTest::testFetch_data()
+{
+    QTest::addColumn<QString>("identifier");
+
+    for (const char *provider : {"apod", "bing", "epod", "flickr", "natgeo", "noaa", "unsplash", "wcpotd"}) {
+        QTest::newRow(provider) << QString::fromLatin1(provider);
+    }
+}
+
+/**
+ * Fetches the picture of every provider through the engine and reports
+ * what it costs, the total time being the benchmark result.
+ *
+ * The decode time runs from the last byte the server sent to the picture
+ * reaching the source, which is what the engine spends decoding and caching
+ * it. The peak RSS is how far the resident size of the process rose above
+ * where it was when the provider started, -1 without /proc.
+ */
+void PotdEngineTest::testFetch()
+{
+    QFETCH(QString, identifier);
+
+    QSignalSpy spy(&m_watcher, &ImageWatcher::imageReady);
+    resetPeakRss();
+    const qint64 rssBefore = memoryStatus("VmRSS");
+    m_server.resetStatistics();
+    QElapsedTimer timer;
+    timer.start();
+
+    m_engine->connectSource(identifier, &m_watcher);
+    QVERIFY(spy.wait(30000));
+    const qint64 total = timer.elapsed();
+    const qint64 peakRss = memoryStatus("VmHWM");
+
+    const QImage image = spy.last().at(1).value<QImage>();
+    QCOMPARE(spy.last().at(0).toString(), identifier);
+    QCOMPARE(image.size(), QSize(3840, 2160));
+
+    qInfo().noquote() << QStringLiteral("%1: first byte %2 ms, total %3 ms, decode %4 ms, %5 requests, %6 KiB sent, peak RSS +%7 KiB")
+                         .arg(identifier).arg(m_server.firstByte()).arg(total).arg(total - m_server.lastByte())
+                         .arg(m_server.requests()).arg(m_server.bytesSent() / 1024)
+                         .arg(peakRss < 0 || rssBefore < 0 ? -1 : peakRss - rssBefore);
+    QTest::setBenchmarkResult(total, QTest::WalltimeMilliseconds);
+
+    m_engine->disconnectSource(identifier, &m_watcher);
+}
+
+/**
+ * A daily picture which is a day old but unchanged on the server must not
+ * be downloaded again.
+ */
+void PotdEngineTest::testConditionalRefresh()
+{
+    const QString identifier = QStringLiteral("apod");
+    const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QLatin1String("/plasma_engine_potd/");
+    QVERIFY(QDir().mkpath(cacheDir));
+
+    // yesterday's fetch of the picture, together with the validators of its page
+    QFile file(cacheDir + identifier);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    QCOMPARE(file.write(m_image), qint64(m_image.size()));
+    QVERIFY(file.setFileTime(QDateTime::currentDateTime().addDays(-1), QFileDevice::FileModificationTime));
+    file.close();
+
+    const QUrl pageUrl(QStringLiteral("http://antwrp.gsfc.nasa.gov/apod/"));
+    const QByteArray page = fixture(QStringLiteral("apod.html"), s_pageSize);
+    {
+        QSettings validators(cacheDir + QLatin1String("validators"), QSettings::IniFormat);
+        validators.beginGroup(QString::fromLatin1(QCryptographicHash::hash(pageUrl.toEncoded(), QCryptographicHash::Md5).toHex()));
+        validators.setValue(QStringLiteral("Identifier"), identifier);
+        validators.setValue(QStringLiteral("ETag"), QString::fromLatin1('"' + QCryptographicHash::hash(page, QCryptographicHash::Md5).toHex() + '"'));
+        validators.setValue(QStringLiteral("Last-Modified"), QString());
+    }
+
+    m_server.resetStatistics();
+    bool updating = false;
+    QVERIFY(QMetaObject::invokeMethod(m_engine, "updateSourceEvent", Qt::DirectConnection,
+                                      Q_RETURN_ARG(bool, updating), Q_ARG(QString, identifier)));
+    QVERIFY(updating);
+
+    QTRY_COMPARE(m_server.notModified(), 1);
+    QCOMPARE(m_server.requests(), 1);
+    QCOMPARE(m_server.bytesSent(), 0);
+}
+
+QTEST_MAIN(PotdEngineTest)
+
+#include "potdenginetest.moc"
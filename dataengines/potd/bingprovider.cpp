@@ -21,30 +21,68 @@
 
 #include <QJsonDocument>
 #include <QJsonArray>
+#include <QJsonObject>
 #include <QDebug>
+#include <QImage>
 
 #include <KPluginFactory>
 #include <KIO/Job>
 
+namespace {
+// HPImageArchive does not list more days than this
+const int s_maxArchiveDays = 8;
+
+QUrl imageUrl(const QJsonValue &imageObj)
+{
+    const QJsonValue url = imageObj.toObject().value(QLatin1String("url"));
+    if (!url.isString() || url.toString().isEmpty()) {
+        return QUrl();
+    }
+    return QUrl(QStringLiteral("https://www.bing.com/%1").arg(url.toString()));
+}
+
+QDate imageDate(const QJsonValue &imageObj)
+{
+    return QDate::fromString(imageObj.toObject().value(QLatin1String("startdate")).toString(), QStringLiteral("yyyyMMdd"));
+}
+}
+
 BingProvider::BingProvider(QObject* parent, const QVariantList& args)
     : PotdProvider(parent, args)
 {
-    const QUrl url(QStringLiteral("https://www.bing.com/HPImageArchive.aspx?format=js&idx=0&n=1"));
+    // a fixed date still covered by the archive can be requested by its index
+    int index = 0;
+    if (isFixedDate()) {
+        const qint64 daysAgo = date().daysTo(QDate::currentDate());
+        if (daysAgo > 0 && daysAgo < s_maxArchiveDays) {
+            index = static_cast<int>(daysAgo);
+        }
+    }
+    const int count = isFixedDate() ? 1 : qBound(1, recentDays(), s_maxArchiveDays);
+
+    const QUrl url(QStringLiteral("https://www.bing.com/HPImageArchive.aspx?format=js&idx=%1&n=%2").arg(index).arg(count));
 
-    KIO::StoredTransferJob* job = KIO::storedGet(url, KIO::NoReload, KIO::HideProgressInfo);
+    // the earlier days are only listed in the response, a "304 Not Modified" would hide them
+    KIO::StoredTransferJob* job = recentDays() > 0 ? unconditionalGet(url) : conditionalGet(url);
     connect(job, &KIO::StoredTransferJob::finished, this, &BingProvider::pageRequestFinished);
+
+    // connected ahead of the engine, so the current day is cached before the provider is gone
+    connect(this, &PotdProvider::finished, this, [this] {
+        if (mImageDate.isValid()) {
+            emit recentImageFetched(this, mImageDate, image());
+        }
+    });
 }
 
 BingProvider::~BingProvider() = default;
 
-QImage BingProvider::image() const
-{
-    return mImage;
-}
-
 void BingProvider::pageRequestFinished(KJob* _job)
 {
     KIO::StoredTransferJob* job = static_cast<KIO::StoredTransferJob*>(_job);
+    if (isNotModified(job)) {
+        emit notModified(this);
+        return;
+    }
     if (job->error()) {
         emit error(this);
         return;
@@ -59,17 +97,24 @@ void BingProvider::pageRequestFinished(KJob* _job)
         if (!imagesArray.isArray() || imagesArray.toArray().size() <= 0) {
             break;
         }
-        auto imageObj = imagesArray.toArray().at(0);
-        if (!imageObj.isObject()) {
+        const QJsonArray images = imagesArray.toArray();
+        const QUrl picUrl = imageUrl(images.at(0));
+        if (!picUrl.isValid()) {
             break;
         }
-        auto url = imageObj.toObject().value(QLatin1String("url"));
-        if (!url.isString() || url.toString().isEmpty()) {
-            break;
+
+        if (recentDays() > 0) {
+            mImageDate = imageDate(images.at(0));
+            // the remaining entries are the days before, all from the same response
+            for (int i = 1; i < images.size(); ++i) {
+                const QUrl recentUrl = imageUrl(images.at(i));
+                const QDate recentDate = imageDate(images.at(i));
+                if (recentUrl.isValid() && recentDate.isValid()) {
+                    requestRecentImage(recentUrl, recentDate);
+                }
+            }
         }
-        QUrl picUrl(QStringLiteral("https://www.bing.com/%1").arg(url.toString()));
-        KIO::StoredTransferJob* imageJob = KIO::storedGet(picUrl, KIO::NoReload, KIO::HideProgressInfo);
-        connect(imageJob, &KIO::StoredTransferJob::finished, this, &BingProvider::imageRequestFinished);
+        requestImage(picUrl);
         return;
     } while (0);
 
@@ -77,18 +122,6 @@ void BingProvider::pageRequestFinished(KJob* _job)
     return;
 }
 
-void BingProvider::imageRequestFinished(KJob* _job)
-{
-    KIO::StoredTransferJob* job = static_cast<KIO::StoredTransferJob*>(_job);
-    if (job->error()) {
-        emit error(this);
-        return;
-    }
-    QByteArray data = job->data();
-    mImage = QImage::fromData(data);
-    emit finished(this);
-}
-
 K_PLUGIN_CLASS_WITH_JSON(BingProvider, "bingprovider.json")
 
 #include "bingprovider.moc"
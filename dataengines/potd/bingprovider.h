@@ -22,13 +22,16 @@
 
 #include "potdprovider.h"
 // Qt
-#include <QImage>
+#include <QDate>
 
 class KJob;
 
 /**
  * This class provides the image for the Bing's homepage
  * url is obtained from https://www.bing.com/HPImageArchive.aspx?format=js&idx=0&n=1
+ *
+ * The archive lists up to eight days in one response, so recent days
+ * are fetched together with the current picture.
  */
 class BingProvider : public PotdProvider
 {
@@ -48,20 +51,11 @@ class BingProvider : public PotdProvider
          */
         ~BingProvider() override;
 
-        /**
-         * Returns the requested image.
-         *
-         * Note: This method returns only a valid image after the
-         *       finished() signal has been emitted.
-         */
-        QImage image() const override;
-
     private:
         void pageRequestFinished(KJob *job);
-        void imageRequestFinished(KJob *job);
 
     private:
-        QImage mImage;
+        QDate mImageDate;
 };
 
 #endif
@@ -21,6 +21,7 @@
 
 #include <QFile>
 #include <QFileInfo>
+#include <QImageReader>
 #include <QTimer>
 #include <QThreadPool>
 #include <QStandardPaths>
@@ -30,16 +31,23 @@
 
 #include <QDebug>
 
-LoadImageThread::LoadImageThread(const QString &filePath)
-    : m_filePath(filePath)
+LoadImageThread::LoadImageThread(const QString &filePath, const QSize &size)
+    : m_filePath(filePath),
+      m_size(size)
 {
 }
 
 void LoadImageThread::run()
 {
-    QImage image;
-    image.load(m_filePath );
-    emit done(image);
+    QImageReader reader(m_filePath);
+    if (m_size.isValid()) {
+        const QSize imageSize = reader.size();
+        // only ever scale down, the item showing it takes care of the rest
+        if (imageSize.width() > m_size.width() && imageSize.height() > m_size.height()) {
+            reader.setScaledSize(imageSize.scaled(m_size, Qt::KeepAspectRatioByExpanding));
+        }
+    }
+    emit done(reader.read());
 }
 
 SaveImageThread::SaveImageThread(const QString &identifier, const QImage &image)
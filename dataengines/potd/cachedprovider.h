@@ -22,6 +22,7 @@
 
 #include <QImage>
 #include <QRunnable>
+#include <QSize>
 
 #include "potdprovider.h"
 
@@ -82,7 +83,11 @@ class LoadImageThread : public QObject, public QRunnable
     Q_OBJECT
 
 public:
-    explicit LoadImageThread(const QString &filePath);
+    /**
+     * Loads the picture at @p filePath; a valid @p size decodes it
+     * already scaled down to cover that size.
+     */
+    explicit LoadImageThread(const QString &filePath, const QSize &size = QSize());
     void run() override;
 
 Q_SIGNALS:
@@ -90,6 +95,7 @@ Q_SIGNALS:
 
 private:
     QString m_filePath;
+    QSize m_size;
 };
 
 class SaveImageThread : public QObject, public QRunnable
@@ -20,60 +20,26 @@
 
 #include "epodprovider.h"
 
-#include <QRegExp>
 #include <QDebug>
 
 #include <KPluginFactory>
-#include <KIO/Job>
 
 EpodProvider::EpodProvider( QObject *parent, const QVariantList &args )
     : PotdProvider(parent, args)
 {
     const QUrl url(QStringLiteral("https://epod.usra.edu/blog/"));
 
-    KIO::StoredTransferJob *job = KIO::storedGet(url, KIO::NoReload, KIO::HideProgressInfo);
-    connect(job, &KIO::StoredTransferJob::finished, this, &EpodProvider::pageRequestFinished);
+    findPageLink(url, QByteArrayLiteral("://epod.usra.edu/.a/"), QByteArrayLiteral("-pi"), [this](const QByteArray &link) {
+        pageLinkFound(link);
+    });
 }
 
 EpodProvider::~EpodProvider() = default;
 
-QImage EpodProvider::image() const
+void EpodProvider::pageLinkFound(const QByteArray &link)
 {
-    return mImage;
-}
-
-void EpodProvider::pageRequestFinished(KJob *_job)
-{
-    KIO::StoredTransferJob *job = static_cast<KIO::StoredTransferJob *>(_job);
-    if ( job->error() ) {
-	emit error(this);
-	return;
-    }
-
-    const QString data = QString::fromUtf8( job->data() );
-
-    const QString pattern = QStringLiteral("://epod.usra.edu/.a/*-pi");
-    QRegExp exp( pattern );
-    exp.setPatternSyntax(QRegExp::Wildcard);
-
-    int pos = exp.indexIn( data ) + pattern.length();
-    const QString sub = data.mid( pos-4, pattern.length()+10);
-    const QUrl url(QStringLiteral("https://epod.usra.edu/.a/%1-pi").arg(sub));
-    KIO::StoredTransferJob *imageJob = KIO::storedGet( url, KIO::NoReload, KIO::HideProgressInfo );
-    connect(imageJob, &KIO::StoredTransferJob::finished, this, &EpodProvider::imageRequestFinished);
-}
-
-void EpodProvider::imageRequestFinished(KJob *_job)
-{
-    KIO::StoredTransferJob *job = static_cast<KIO::StoredTransferJob *>(_job);
-    if ( job->error() ) {
-	emit error(this);
-	return;
-    }
-
-    // FIXME: this really should be done in a thread as this can block
-    mImage = QImage::fromData( job->data() );
-    emit finished(this);
+    const QUrl url(QStringLiteral("https://epod.usra.edu/.a/%1-pi").arg(QString::fromUtf8(link)));
+    requestImage(url);
 }
 
 K_PLUGIN_CLASS_WITH_JSON(EpodProvider, "epodprovider.json")
@@ -23,10 +23,6 @@
 
 #include "potdprovider.h"
 // Qt
-#include <QImage>
-
-class KJob;
-
 /**
  * This class provides the image for EPOD 
  * "Earth Science Picture Of the Day"
@@ -50,20 +46,8 @@ class EpodProvider : public PotdProvider
          */
         ~EpodProvider() override;
 
-        /**
-         * Returns the requested image.
-         *
-         * Note: This method returns only a valid image after the
-         *       finished() signal has been emitted.
-         */
-        QImage image() const override;
-
-    private:
-        void pageRequestFinished(KJob *job);
-        void imageRequestFinished(KJob *job);
-
     private:
-        QImage mImage;
+        void pageLinkFound(const QByteArray &link);
 };
 
 #endif
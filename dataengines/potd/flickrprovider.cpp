@@ -51,20 +51,19 @@ FlickrProvider::FlickrProvider(QObject *parent, const QVariantList &args)
 
     const QUrl url = buildUrl(mActualDate);
 
-    KIO::StoredTransferJob *job = KIO::storedGet(url, KIO::NoReload, KIO::HideProgressInfo);
+    KIO::StoredTransferJob *job = conditionalGet(url);
     connect(job, &KIO::StoredTransferJob::finished, this, &FlickrProvider::pageRequestFinished);
 }
 
 FlickrProvider::~FlickrProvider() = default;
 
-QImage FlickrProvider::image() const
-{
-    return mImage;
-}
-
 void FlickrProvider::pageRequestFinished(KJob *_job)
 {
     KIO::StoredTransferJob *job = static_cast<KIO::StoredTransferJob *>( _job );
+    if (isNotModified(job)) {
+        emit notModified(this);
+        return;
+    }
     if (job->error()) {
         emit error(this);
         qDebug() << "pageRequestFinished error";
@@ -92,7 +91,7 @@ void FlickrProvider::pageRequestFinished(KJob *_job)
                         /* To be sure, decrement the date to two days earlier... @TODO */
                         mActualDate = mActualDate.addDays(-2);
                         QUrl url = buildUrl(mActualDate);
-                        KIO::StoredTransferJob *pageJob = KIO::storedGet(url, KIO::NoReload, KIO::HideProgressInfo);
+                        KIO::StoredTransferJob *pageJob = conditionalGet(url);
                         connect(pageJob, &KIO::StoredTransferJob::finished, this, &FlickrProvider::pageRequestFinished);
                         mFailureNumber++;
                         return;
@@ -141,25 +140,12 @@ void FlickrProvider::pageRequestFinished(KJob *_job)
 
     if (m_photoList.begin() != m_photoList.end()) {
         QUrl url( m_photoList.at(QRandomGenerator::global()->bounded(m_photoList.size())) );
-            KIO::StoredTransferJob *imageJob = KIO::storedGet(url, KIO::NoReload, KIO::HideProgressInfo);
-            connect(imageJob, &KIO::StoredTransferJob::finished, this, &FlickrProvider::imageRequestFinished);
+            requestImage(url);
     } else {
         qDebug() << "empty list";
     }
 }
 
-void FlickrProvider::imageRequestFinished(KJob *_job)
-{
-    KIO::StoredTransferJob *job = static_cast<KIO::StoredTransferJob *>( _job );
-    if ( job->error() ) {
-        emit error(this);
-        return;
-    }
-
-    mImage = QImage::fromData( job->data() );
-    emit finished(this);
-}
-
 K_PLUGIN_CLASS_WITH_JSON(FlickrProvider, "flickrprovider.json")
 
 #include "flickrprovider.moc"
@@ -24,7 +24,6 @@
 
 #include "potdprovider.h"
 // Qt
-#include <QImage>
 #include <QDate>
 #include <QXmlStreamReader>
 
@@ -54,21 +53,11 @@ class FlickrProvider : public PotdProvider
          */
         ~FlickrProvider() override;
 
-        /**
-         * Returns the requested image.
-         *
-         * Note: This method returns only a valid image after the
-         *       finished() signal has been emitted.
-         */
-        QImage image() const override;
-
     private:
         void pageRequestFinished(KJob *job);
-        void imageRequestFinished(KJob *job);
 
     private:
         QDate mActualDate;
-        QImage mImage;
 
         QXmlStreamReader xml;
 
@@ -22,9 +22,10 @@
 #include "natgeoprovider.h"
 
 #include <QDebug>
+#include <QRegularExpression>
 
 #include <KPluginFactory>
-#include <KIO/Job>
+#include <KIO/StoredTransferJob>
 
 
 NatGeoProvider::NatGeoProvider(QObject *parent, const QVariantList &args)
@@ -32,20 +33,20 @@ NatGeoProvider::NatGeoProvider(QObject *parent, const QVariantList &args)
 {
     const QUrl url(QStringLiteral("https://www.nationalgeographic.com/photography/photo-of-the-day/"));
 
-    KIO::StoredTransferJob *job = KIO::storedGet(url, KIO::NoReload, KIO::HideProgressInfo);
-    connect(job, &KIO::StoredTransferJob::finished, this, &NatGeoProvider::pageRequestFinished);
+    // the whole page is needed, the picture is the last og:image of it, see pageRequestFinished()
+    KIO::StoredTransferJob *job = conditionalGet(url);
+    connect(job, &KJob::result, this, &NatGeoProvider::pageRequestFinished);
 }
 
 NatGeoProvider::~NatGeoProvider() = default;
 
-QImage NatGeoProvider::image() const
-{
-    return mImage;
-}
-
-void NatGeoProvider::pageRequestFinished(KJob* _job)
+void NatGeoProvider::pageRequestFinished(KJob *_job)
 {
     KIO::StoredTransferJob *job = static_cast<KIO::StoredTransferJob *>( _job );
+    if (isNotModified(job)) {
+        emit notModified(this);
+        return;
+    }
     if (job->error()) {
         emit error(this);
         return;
@@ -56,10 +57,10 @@ void NatGeoProvider::pageRequestFinished(KJob* _job)
 
     QString url;
 
-    re.setPattern(QStringLiteral("^<meta\\s+property=\"og:image\"\\s+content=\"(.*)\".*/>$"));
+    static const QRegularExpression re(QStringLiteral("^<meta\\s+property=\"og:image\"\\s+content=\"(.*)\".*/>$"));
 
-    for (int i = 0; i < lines.size(); i++) {
-        QRegularExpressionMatch match = re.match(lines.at(i));
+    for (const QString &line : lines) {
+        QRegularExpressionMatch match = re.match(line);
         if (match.hasMatch()) {
             url = match.captured(1);
         }
@@ -70,20 +71,7 @@ void NatGeoProvider::pageRequestFinished(KJob* _job)
         return;
     }
 
-    KIO::StoredTransferJob *imageJob = KIO::storedGet( QUrl(url), KIO::NoReload, KIO::HideProgressInfo );
-    connect(imageJob, &KIO::StoredTransferJob::finished, this, &NatGeoProvider::imageRequestFinished);
-}
-
-void NatGeoProvider::imageRequestFinished(KJob *_job)
-{
-    KIO::StoredTransferJob *job = static_cast<KIO::StoredTransferJob *>( _job );
-    if ( job->error() ) {
-        emit error(this);
-        return;
-    }
-
-    mImage = QImage::fromData( job->data() );
-    emit finished(this);
+    requestImage(QUrl(url));
 }
 
 K_PLUGIN_CLASS_WITH_JSON(NatGeoProvider, "natgeoprovider.json")
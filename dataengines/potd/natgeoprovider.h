@@ -23,12 +23,9 @@
 #define NATGEOPROVIDER_H
 
 #include "potdprovider.h"
-// Qt
-#include <QImage>
-#include <QRegularExpression>
 
 class KJob;
-
+// Qt
 /**
  * This class provides the image for APOD 
  * "Astronomy Picture Of the Day"
@@ -56,22 +53,8 @@ class NatGeoProvider : public PotdProvider
          */
         ~NatGeoProvider() override;
 
-        /**
-         * Returns the requested image.
-         *
-         * Note: This method returns only a valid image after the
-         *       finished() signal has been emitted.
-         */
-        QImage image() const override;
-
     private:
         void pageRequestFinished(KJob *job);
-        void imageRequestFinished(KJob *job);
-
-    private:
-        QImage mImage;
-
-        QRegularExpression re;
 };
 
 #endif
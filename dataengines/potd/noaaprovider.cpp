@@ -20,68 +20,33 @@
 
 #include "noaaprovider.h"
 
-#include <QRegularExpression>
 #include <QDebug>
 
 #include <KPluginFactory>
-#include <KIO/Job>
 
 NOAAProvider::NOAAProvider(QObject *parent, const QVariantList &args)
     : PotdProvider(parent, args)
 {
     const QUrl url(QStringLiteral("https://www.nesdis.noaa.gov/content/imagery-and-data"));
 
-    KIO::StoredTransferJob *job = KIO::storedGet(url, KIO::NoReload, KIO::HideProgressInfo);
-    connect(job, &KIO::StoredTransferJob::finished, this, &NOAAProvider::pageRequestFinished);
+    // The HTML NOAA page itself is not a valid XML file, so the first
+    // quoted jpg link below the files directory is taken as the picture.
+    findPageLink(url, QByteArrayLiteral("\"/sites/default/files/"), QByteArrayLiteral(".jpg\""), [this](const QByteArray &link) {
+        pageLinkFound(link);
+    });
 }
 
 NOAAProvider::~NOAAProvider() = default;
 
-QImage NOAAProvider::image() const
+void NOAAProvider::pageLinkFound(const QByteArray &link)
 {
-    return mImage;
-}
-
-void NOAAProvider::pageRequestFinished(KJob* _job)
-{
-    KIO::StoredTransferJob *job = static_cast<KIO::StoredTransferJob *>( _job );
-    if (job->error()) {
-        emit error(this);
-        return;
-    }
-
-    const QString data = QString::fromUtf8( job->data() );
-
-    // Using regular expression could be fragile in such case, but the HTML
-    // NOAA page itself is not a valid XML file and unfortunately it could
-    // not be parsed successfully till the content we want. And we do not want
-    // to use heavy weight QtWebkit. So we use QRegularExpression to capture
-    // the wanted url here.
-    QUrl url;
-    QRegularExpression re(QStringLiteral("\"(/sites/default/files/.*\\.jpg)\""));
-    auto result = re.match(data);
-    if (result.hasMatch()) {
-        url = QUrl(QStringLiteral("https://www.nesdis.noaa.gov") + result.captured(1));
-    }
+    const QUrl url(QLatin1String("https://www.nesdis.noaa.gov/sites/default/files/") + QString::fromUtf8(link) + QLatin1String(".jpg"));
     if (!url.isValid()) {
         emit error(this);
         return;
     }
 
-    KIO::StoredTransferJob *imageJob = KIO::storedGet( url, KIO::NoReload, KIO::HideProgressInfo );
-    connect(imageJob, &KIO::StoredTransferJob::finished, this, &NOAAProvider::imageRequestFinished);
-}
-
-void NOAAProvider::imageRequestFinished(KJob *_job)
-{
-    KIO::StoredTransferJob *job = static_cast<KIO::StoredTransferJob *>( _job );
-    if ( job->error() ) {
-	emit error(this);
-	return;
-    }
-
-    mImage = QImage::fromData( job->data() );
-    emit finished(this);
+    requestImage(url);
 }
 
 K_PLUGIN_CLASS_WITH_JSON(NOAAProvider, "noaaprovider.json")
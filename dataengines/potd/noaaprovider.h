@@ -24,10 +24,6 @@
 
 #include "potdprovider.h"
 // Qt
-#include <QImage>
-
-class KJob;
-
 /**
  * This class provides the image for NOAA Environmental Visualization Laboratory
  * Image Of the Day
@@ -51,20 +47,8 @@ class NOAAProvider : public PotdProvider
          */
         ~NOAAProvider() override;
 
-        /**
-         * Returns the requested image.
-         *
-         * Note: This method returns only a valid image after the
-         *       finished() signal has been emitted.
-         */
-        QImage image() const override;
-
     private:
-        void pageRequestFinished(KJob *job);
-        void imageRequestFinished(KJob *job);
-
-   private:
-        QImage mImage;
+        void pageLinkFound(const QByteArray &link);
 };
 
 #endif
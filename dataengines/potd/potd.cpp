@@ -23,6 +23,7 @@
 #include <QFile>
 #include <QFileInfo>
 #include <QRegularExpression>
+#include <QSize>
 #include <QTimer>
 #include <QThreadPool>
 #include <QDebug>
@@ -38,6 +39,24 @@ namespace DataKeys {
 inline QString image() { return QStringLiteral("Image"); }
 inline QString url()   { return QStringLiteral("Url"); }
 }
+
+// "<identifier>@<width>x<height>" is the picture of <identifier>, decoded to cover that size
+bool parseScaledSource( const QString &source, QString *identifier, QSize *size )
+{
+    static const QRegularExpression re(QStringLiteral("^(.+)@(\\d+)x(\\d+)$"));
+    const QRegularExpressionMatch match = re.match( source );
+    if ( !match.hasMatch() ) {
+        return false;
+    }
+
+    *identifier = match.captured( 1 );
+    *size = QSize( match.capturedRef( 2 ).toInt(), match.capturedRef( 3 ).toInt() );
+    return size->isValid() && !size->isEmpty();
+}
+
+// failed sources are retried after 1, 2, 4, ... minutes, at most every hour
+const int s_retryMinimum = 60 * 1000;
+const int s_retryMaximum = 60 * 60 * 1000;
 }
 
 PotdEngine::PotdEngine( QObject* parent, const QVariantList& args )
@@ -51,7 +70,41 @@ PotdEngine::PotdEngine( QObject* parent, const QVariantList& args )
     // time insensitive sources to serve; still, this is better than how i found it, checking
     // every 2 seconds (!)
     m_checkDatesTimer->setInterval( 10 * 60 * 1000 ); // check every 10 minutes
-    m_checkDatesTimer->start();
+    // there is no point in checking while offline, onOnlineStateChanged() catches up
+    if ( isOnline() ) {
+        m_checkDatesTimer->start();
+    }
+
+    connect( &m_networkConfigurationManager, &QNetworkConfigurationManager::onlineStateChanged,
+             this, &PotdEngine::onOnlineStateChanged );
+    connect( this, &Plasma::DataEngine::sourceRemoved, this, &PotdEngine::forgetFailures );
+    connect( this, &Plasma::DataEngine::sourceRemoved, this, [this]( const QString &source ) {
+        // nobody is waiting for it anymore, destroying the provider aborts its transfers
+        const QList<PotdProvider *> providers = findChildren<PotdProvider *>( QString(), Qt::FindDirectChildrenOnly );
+        for ( PotdProvider *provider : providers ) {
+            if ( provider->identifier() == source && !qobject_cast<CachedProvider *>( provider ) ) {
+                provider->disconnect( this );
+                provider->deleteLater();
+            }
+        }
+
+        QString identifier;
+        QSize size;
+        if ( parseScaledSource( source, &identifier, &size ) ) {
+            m_scaledSources[ identifier ].remove( source );
+            if ( m_scaledSources[ identifier ].isEmpty() ) {
+                m_scaledSources.remove( identifier );
+                // nobody but its scaled sources asked for it, and they are all gone
+                if ( m_internalSources.remove( identifier ) ) {
+                    Plasma::DataContainer *base = containerForSource( identifier );
+                    if ( base && !base->isUsed() ) {
+                        removeSource( identifier );
+                    }
+                }
+            }
+        }
+        m_internalSources.remove( source );
+    });
 
     const QVector<KPluginMetaData> plugins = KPluginLoader::findPlugins(QStringLiteral("potd"), [](const KPluginMetaData & md) {
         return md.serviceTypes().contains(QStringLiteral("PlasmaPoTD/Plugin"));
@@ -64,6 +117,8 @@ PotdEngine::PotdEngine( QObject* parent, const QVariantList& args )
         }
         mFactories.insert(provider, metadata);
         setData( QLatin1String( "Providers" ), provider, metadata.name() );
+        setData( QLatin1String( "RecentDays" ), provider,
+                 metadata.value( QStringLiteral( "X-KDE-PlasmaPoTDProvider-RecentDays" ) ).toInt() );
     }
 }
 
@@ -73,13 +128,25 @@ PotdEngine::~PotdEngine()
 
 bool PotdEngine::updateSourceEvent( const QString &identifier )
 {
+    QString baseIdentifier;
+    QSize size;
+    if ( parseScaledSource( identifier, &baseIdentifier, &size ) ) {
+        return updateSource( baseIdentifier, false );
+    }
+
     return updateSource( identifier, false );
 }
 
 bool PotdEngine::updateSource( const QString &identifier, bool loadCachedAlways )
 {
+    // only leading to scaled sources, which decode the cached file on their own
+    if ( isInternalSource( identifier ) && CachedProvider::isCached( identifier, loadCachedAlways ) ) {
+        cachingFinished( identifier, CachedProvider::identifierToPath( identifier ), QImage() );
+        if ( !loadCachedAlways ) {
+            return true;
+        }
     // check whether it is cached already...
-    if ( CachedProvider::isCached( identifier, loadCachedAlways ) ) {
+    } else if ( CachedProvider::isCached( identifier, loadCachedAlways ) ) {
         QVariantList args;
         args << QLatin1String( "String" ) << identifier;
 
@@ -108,12 +175,27 @@ bool PotdEngine::updateSource( const QString &identifier, bool loadCachedAlways
         return false;
     }
     
+    // nothing to fetch now, onOnlineStateChanged() does once there is a connection
+    if ( !isOnline() ) {
+        m_failures[ identifier ] = qMax( 1, m_failures.value( identifier ) );
+        return true;
+    }
+
     QVariantList args;
 
     for (int i = 0; i < parts.count(); i++) {
         args << parts[i];
     }
 
+    // let providers which can list several days at once fill the cache of the
+    // days missing since the last run with the same request
+    if ( parts.count() == 1 ) {
+        const int recentDays = uncachedRecentDays( providerName );
+        if ( recentDays > 0 ) {
+            args << QStringLiteral( "recent=%1" ).arg( recentDays );
+        }
+    }
+
     auto factory = KPluginLoader(mFactories[ providerName ].fileName()).factory();
     PotdProvider *provider = nullptr;
     if (factory) {
@@ -122,14 +204,62 @@ bool PotdEngine::updateSource( const QString &identifier, bool loadCachedAlways
     if (provider) {
         connect( provider, SIGNAL(finished(PotdProvider*)), this, SLOT(finished(PotdProvider*)) );
         connect( provider, SIGNAL(error(PotdProvider*)), this, SLOT(error(PotdProvider*)) );
+        connect( provider, SIGNAL(recentImageFetched(PotdProvider*,QDate,QImage)), this, SLOT(recentImageFetched(PotdProvider*,QDate,QImage)) );
+        connect( provider, SIGNAL(notModified(PotdProvider*)), this, SLOT(notModified(PotdProvider*)) );
         return true;
     }
 
     return false;
 }
 
+int PotdEngine::uncachedRecentDays( const QString &providerName ) const
+{
+    const int maxDays = mFactories[ providerName ].value( QStringLiteral( "X-KDE-PlasmaPoTDProvider-RecentDays" ) ).toInt();
+    if ( maxDays <= 0 ) {
+        return 0;
+    }
+
+    // the current day is never cached yet when the daily picture is fetched,
+    // so ask for at least that one, and back to the oldest day missing
+    const QDate today = QDate::currentDate();
+    for ( int i = maxDays - 1; i > 0; --i ) {
+        const QString identifier = providerName + QLatin1Char( ':' ) + today.addDays( -i ).toString( Qt::ISODate );
+        if ( !QFile::exists( CachedProvider::identifierToPath( identifier ) ) ) {
+            return i + 1;
+        }
+    }
+
+    return 1;
+}
+
 bool PotdEngine::sourceRequestEvent( const QString &identifier )
 {
+    QString baseIdentifier;
+    QSize size;
+    if ( parseScaledSource( identifier, &baseIdentifier, &size ) ) {
+        // follows the plain source, which is fetched and cached as usual
+        Plasma::DataContainer *base = containerForSource( baseIdentifier );
+        m_scaledSources[ baseIdentifier ].insert( identifier );
+        setData(identifier, DataKeys::image(), QImage());
+
+        if ( !base ) {
+            // loads this one once the plain source has its picture, see cachingFinished()
+            m_internalSources.insert( baseIdentifier );
+            if ( !sourceRequestEvent( baseIdentifier ) ) {
+                m_internalSources.remove( baseIdentifier );
+                removeSource( identifier );
+                return false;
+            }
+            return true;
+        }
+
+        const QString path = base->data().value( DataKeys::url() ).toString();
+        if ( !path.isEmpty() ) {
+            loadScaled( identifier, path, size );
+        }
+        return true;
+    }
+
     if ( updateSource( identifier, true ) ) {
         setData(identifier, DataKeys::image(), QImage());
         return true;
@@ -149,33 +279,173 @@ void PotdEngine::finished( PotdProvider *provider )
     }
 
     QImage img(provider->image());
-    // store in cache if it's not the response of a CachedProvider
-    if ( qobject_cast<CachedProvider*>( provider ) == nullptr && !img.isNull() ) {
+    if ( qobject_cast<CachedProvider*>( provider ) == nullptr ) {
+        forgetFailures( provider->identifier() );
+    }
+
+    // store in cache if it's not the response of a CachedProvider, nor stored by the provider itself
+    if ( qobject_cast<CachedProvider*>( provider ) == nullptr && !provider->isImageCached() && !img.isNull() ) {
         SaveImageThread *thread = new SaveImageThread( provider->identifier(), img );
         connect(thread, SIGNAL(done(QString,QString,QImage)), this, SLOT(cachingFinished(QString,QString,QImage)));
         QThreadPool::globalInstance()->start(thread);
     } else {
-        setData(provider->identifier(), DataKeys::image(), img);
-        setData(provider->identifier(), DataKeys::url(), CachedProvider::identifierToPath( provider->identifier()));
+        cachingFinished( provider->identifier(), CachedProvider::identifierToPath( provider->identifier() ), img );
     }
 
     provider->deleteLater();
 }
 
+bool PotdEngine::isInternalSource( const QString &source ) const
+{
+    if ( !m_internalSources.contains( source ) ) {
+        return false;
+    }
+    Plasma::DataContainer *container = containerForSource( source );
+    return !container || !container->isUsed();
+}
+
 void PotdEngine::cachingFinished( const QString &source, const QString &path, const QImage &img )
 {
-    setData(source, DataKeys::image(), img);
+    // the full picture of a source only there for its scaled sources would be kept for nothing
+    const bool internal = isInternalSource( source );
+    setData(source, DataKeys::image(), internal ? QImage() : img);
     setData(source, DataKeys::url(), path);
+
+    if ( img.isNull() && !internal ) {
+        return;
+    }
+
+    const QStringList scaledSources = m_scaledSources.value( source ).values();
+    for ( const QString &scaledSource : scaledSources ) {
+        QString identifier;
+        QSize size;
+        parseScaledSource( scaledSource, &identifier, &size );
+        loadScaled( scaledSource, path, size );
+    }
+}
+
+void PotdEngine::loadScaled( const QString &source, const QString &path, const QSize &size )
+{
+    // decoding straight to the wanted size is far cheaper than scaling the full picture later
+    LoadImageThread *thread = new LoadImageThread( path, size );
+    connect( thread, &LoadImageThread::done, this, [this, source, path]( const QImage &img ) {
+        if ( containerForSource( source ) && !img.isNull() ) {
+            setData( source, DataKeys::image(), img );
+            setData( source, DataKeys::url(), path );
+        }
+    });
+    QThreadPool::globalInstance()->start( thread );
+}
+
+void PotdEngine::recentImageFetched( PotdProvider *provider, const QDate &date, const QImage &img )
+{
+    const QString identifier = provider->name() + QLatin1Char( ':' ) + date.toString( Qt::ISODate );
+    SaveImageThread *thread = new SaveImageThread( identifier, img );
+    connect(thread, SIGNAL(done(QString,QString,QImage)), this, SLOT(recentCachingFinished(QString,QString,QImage)));
+    QThreadPool::globalInstance()->start(thread);
+}
+
+void PotdEngine::recentCachingFinished( const QString &source, const QString &path, const QImage &img )
+{
+    // only update sources somebody is connected to, the others are served from the cache later
+    if ( containerForSource( source ) ) {
+        cachingFinished( source, path, img );
+    }
 }
 
 void PotdEngine::error( PotdProvider *provider )
 {
     provider->disconnect(this);
     provider->deleteLater();
+
+    if ( qobject_cast<CachedProvider *>( provider ) == nullptr ) {
+        scheduleRetry( provider->identifier() );
+    }
+}
+
+void PotdEngine::scheduleRetry( const QString &identifier )
+{
+    const int failures = ++m_failures[ identifier ];
+    if ( !isOnline() ) {
+        // retried as soon as the connection is back
+        return;
+    }
+
+    QTimer *timer = m_retryTimers.value( identifier );
+    if ( !timer ) {
+        timer = new QTimer( this );
+        timer->setSingleShot( true );
+        connect( timer, &QTimer::timeout, this, [this, identifier, timer] {
+            // done backing off, whatever becomes of the retry, checkDayChanged() looks after
+            // the source again; the failure count stays for the backoff of a further failure
+            m_retryTimers.remove( identifier );
+            timer->deleteLater();
+            if ( containerForSource( identifier ) ) {
+                updateSource( identifier, false );
+            } else {
+                forgetFailures( identifier );
+            }
+        });
+        m_retryTimers.insert( identifier, timer );
+    }
+
+    timer->start( qMin( s_retryMaximum, s_retryMinimum << qMin( failures - 1, 6 ) ) );
+}
+
+void PotdEngine::forgetFailures( const QString &identifier )
+{
+    m_failures.remove( identifier );
+    // might be called from the timeout of that very timer
+    if ( QTimer *timer = m_retryTimers.take( identifier ) ) {
+        timer->deleteLater();
+    }
+}
+
+bool PotdEngine::isOnline() const
+{
+    // requests of the autotests never leave the machine
+    return m_networkConfigurationManager.isOnline() || qEnvironmentVariableIsSet( "PLASMA_POTD_TEST_SERVER" );
+}
+
+void PotdEngine::onOnlineStateChanged( bool online )
+{
+    if ( !online ) {
+        m_checkDatesTimer->stop();
+        for ( QTimer *timer : qAsConst( m_retryTimers ) ) {
+            timer->stop();
+        }
+        return;
+    }
+
+    // the connection is back: retry what failed right away, with a fresh backoff
+    const QStringList failed = m_failures.keys();
+    for ( const QString &identifier : failed ) {
+        forgetFailures( identifier );
+        if ( containerForSource( identifier ) ) {
+            updateSource( identifier, false );
+        }
+    }
+
+    checkDayChanged();
+    m_checkDatesTimer->start();
+}
+
+void PotdEngine::notModified( PotdProvider *provider )
+{
+    forgetFailures( provider->identifier() );
+
+    // keep showing the cached picture; its age is left alone so that the next
+    // checkDayChanged() asks again, which is cheap while nothing changed
+    provider->disconnect(this);
+    provider->deleteLater();
 }
 
 void PotdEngine::checkDayChanged()
 {
+    if ( !isOnline() ) {
+        return;
+    }
+
     SourceDict dict = containerDict();
     QHashIterator<QString, Plasma::DataContainer*> it( dict );
     QRegularExpression re(QLatin1String(":\\d{4}-\\d{2}-\\d{2}"));
@@ -183,7 +453,19 @@ void PotdEngine::checkDayChanged()
     while ( it.hasNext() ) {
         it.next();
 
-        if (it.key() == QLatin1String("Providers")) {
+        if (it.key() == QLatin1String("Providers") || it.key() == QLatin1String("RecentDays")) {
+            continue;
+        }
+
+        // backing off after a failure, its retry timer takes care of it
+        if ( m_retryTimers.contains( it.key() ) ) {
+            continue;
+        }
+
+        // scaled sources follow their plain source
+        QString baseIdentifier;
+        QSize size;
+        if ( parseScaledSource( it.key(), &baseIdentifier, &size ) ) {
             continue;
         }
 
@@ -22,9 +22,14 @@
 
 #include <Plasma/DataEngine>
 #include <KPluginMetaData>
+// Qt
+#include <QNetworkConfigurationManager>
+#include <QSet>
 
 class PotdProvider;
 
+class QDate;
+class QSize;
 class QTimer;
 
 /**
@@ -36,6 +41,9 @@ class QTimer;
  *   apod:2007-07-19
  *   unsplash:12435322
  *
+ * The source "Providers" lists the names of the providers, "RecentDays" how
+ * many days, counting back from today, each of them serves at once.
+ *
  */
 class PotdEngine : public Plasma::DataEngine
 {
@@ -54,15 +62,32 @@ class PotdEngine : public Plasma::DataEngine
     private Q_SLOTS:
         void finished( PotdProvider* );
         void error( PotdProvider* );
+        void notModified( PotdProvider* );
+        void onOnlineStateChanged( bool online );
         void checkDayChanged();
         void cachingFinished( const QString &source, const QString &path, const QImage &img );
+        void recentImageFetched( PotdProvider *provider, const QDate &date, const QImage &img );
+        void recentCachingFinished( const QString &source, const QString &path, const QImage &img );
 
     private:
         bool updateSource( const QString &identifier, bool loadCachedAlways );
+        int uncachedRecentDays( const QString &providerName ) const;
+        bool isInternalSource( const QString &source ) const;
+        void loadScaled( const QString &source, const QString &path, const QSize &size );
+        bool isOnline() const;
+        void scheduleRetry( const QString &identifier );
+        void forgetFailures( const QString &identifier );
 
         QMap<QString, KPluginMetaData> mFactories;
         QTimer *m_checkDatesTimer;
         bool m_canDiscardCache;
+        QNetworkConfigurationManager m_networkConfigurationManager;
+        QHash<QString, int> m_failures;
+        QHash<QString, QTimer *> m_retryTimers;
+        // plain identifier -> sources asking for it at a given size
+        QHash<QString, QSet<QString>> m_scaledSources;
+        // plain identifiers only requested on behalf of their scaled sources
+        QSet<QString> m_internalSources;
 };
 
 #endif
@@ -0,0 +1,95 @@
+/*
+ *   Copyright 2020 Guo Yunhe <i@guoyunhe.me>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "potdlinkscanner.h"
+
+namespace {
+bool isLinkCharacter(char c)
+{
+    switch (c) {
+    case '"':
+    case '\'':
+    case '<':
+    case '>':
+    case ' ':
+    case '\t':
+    case '\r':
+    case '\n':
+        return false;
+    default:
+        return true;
+    }
+}
+}
+
+PotdLinkScanner::PotdLinkScanner( const QByteArray &prefix, const QByteArray &terminator, int maxLength )
+    : mPrefix( prefix ),
+      mTerminator( terminator ),
+      mMaxLength( maxLength )
+{
+}
+
+bool PotdLinkScanner::feed( const QByteArray &data )
+{
+    if ( mFound ) {
+        return true;
+    }
+
+    mBuffer += data;
+
+    const int prefixLength = mPrefix.pattern().size();
+    int from = 0;
+    while ( true ) {
+        const int begin = mPrefix.indexIn( mBuffer, from );
+        if ( begin < 0 ) {
+            // only keep what could be the start of a prefix split between chunks
+            mBuffer = mBuffer.right( qMax( 0, prefixLength - 1 ) );
+            return false;
+        }
+
+        const int start = begin + prefixLength;
+        int end = start;
+        while ( end < mBuffer.size() && end - start <= mMaxLength && isLinkCharacter( mBuffer.at( end ) ) ) {
+            ++end;
+        }
+
+        // the terminator may end with the character closing the candidate, like a quote
+        const int candidateEnd = qMin( end + mTerminator.size(), mBuffer.size() );
+        const int terminatorPos = QByteArray::fromRawData( mBuffer.constData() + start, candidateEnd - start ).indexOf( mTerminator );
+        if ( terminatorPos > 0 && terminatorPos <= end - start ) {
+            mLink = mBuffer.mid( start, terminatorPos );
+            mFound = true;
+            mBuffer.clear();
+            return true;
+        }
+
+        if ( end == mBuffer.size() && end - start <= mMaxLength ) {
+            // the candidate might go on in the next chunk
+            mBuffer.remove( 0, begin );
+            return false;
+        }
+
+        from = start;
+    }
+}
+
+QByteArray PotdLinkScanner::link() const
+{
+    return mLink;
+}
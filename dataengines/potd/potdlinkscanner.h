@@ -0,0 +1,62 @@
+/*
+ *   Copyright 2020 Guo Yunhe <i@guoyunhe.me>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef POTDLINKSCANNER_H
+#define POTDLINKSCANNER_H
+
+#include <QByteArray>
+#include <QByteArrayMatcher>
+
+#include "plasma_potd_export.h"
+
+/**
+ * Finds the first link between a fixed prefix and terminator in a page
+ * which is fed chunk by chunk, without decoding or keeping the whole page.
+ *
+ * Candidates longer than the maximum length or containing quotes, angle
+ * brackets or whitespace are skipped, so a terminator further down the
+ * page never turns a stray prefix into a match.
+ */
+class PLASMA_POTD_EXPORT PotdLinkScanner
+{
+    public:
+        PotdLinkScanner( const QByteArray &prefix, const QByteArray &terminator, int maxLength = 2048 );
+
+        /**
+         * Scans the next chunk of the page.
+         *
+         * @return whether the link has been found, possibly in an earlier chunk
+         */
+        bool feed( const QByteArray &data );
+
+        /**
+         * @return the link found, without prefix and terminator
+         */
+        QByteArray link() const;
+
+    private:
+        QByteArrayMatcher mPrefix;
+        QByteArray mTerminator;
+        QByteArray mBuffer;
+        QByteArray mLink;
+        int mMaxLength;
+        bool mFound = false;
+};
+
+#endif
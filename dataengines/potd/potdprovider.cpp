@@ -20,7 +20,96 @@
 #include "potdprovider.h"
 
 // Qt
+#include <QCryptographicHash>
 #include <QDate>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include <QPointer>
+#include <QRunnable>
+#include <QSet>
+#include <QSettings>
+#include <QSharedPointer>
+#include <QStandardPaths>
+#include <QTemporaryFile>
+#include <QThreadPool>
+#include <QUrl>
+#include <QVector>
+
+// KF
+#include <KIO/StoredTransferJob>
+#include <KIO/TransferJob>
+
+#include "potdlinkscanner.h"
+
+namespace {
+// the engine caches the pictures in this directory, see CachedProvider::identifierToPath()
+QString cacheDir()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QLatin1String("/plasma_engine_potd/");
+}
+
+QString validatorsGroup(const QUrl &url)
+{
+    return QString::fromLatin1(QCryptographicHash::hash(url.toEncoded(), QCryptographicHash::Md5).toHex());
+}
+
+// Lets the autotests serve every request from a local stand-in server:
+// https://host/path becomes <PLASMA_POTD_TEST_SERVER>/host/path
+QUrl requestUrl(const QUrl &url)
+{
+    static const QByteArray testServer = qgetenv("PLASMA_POTD_TEST_SERVER");
+    if (testServer.isEmpty()) {
+        return url;
+    }
+
+    QUrl redirected(QString::fromLatin1(testServer));
+    redirected.setPath(QLatin1Char('/') + url.host() + url.path());
+    redirected.setQuery(url.query(QUrl::FullyEncoded), QUrl::StrictMode);
+    return redirected;
+}
+
+// error pages come with a body as well, which must not end up as the picture
+bool isErrorResponse(KIO::TransferJob *job)
+{
+    return job->isErrorPage() || job->queryMetaData(QStringLiteral("responsecode")).toInt() >= 400;
+}
+
+struct Validators
+{
+    QString eTag;
+    QString lastModified;
+};
+}
+
+class PotdDecodeImageThread : public QObject, public QRunnable
+{
+    Q_OBJECT
+
+public:
+    explicit PotdDecodeImageThread(const QString &filePath)
+        : m_filePath(filePath)
+    {
+    }
+
+    explicit PotdDecodeImageThread(const QByteArray &data)
+        : m_data(data)
+    {
+    }
+
+    void run() override
+    {
+        emit done(m_filePath.isEmpty() ? QImage::fromData(m_data) : QImage(m_filePath));
+    }
+
+Q_SIGNALS:
+    void done(const QImage &image);
+
+private:
+    QString m_filePath;
+    QByteArray m_data;
+};
 
 class PotdProviderPrivate
 {
@@ -28,8 +117,152 @@ public:
     QString name;
     QDate date;
     QString identifier;
+    int recentDays = 0;
+
+    QHash<KIO::TransferJob *, QUrl> conditionalJobs;
+    QHash<QUrl, Validators> pendingValidators;
+    // answered with "304 Not Modified", their stored validators are still current
+    QSet<QUrl> confirmedUrls;
+    // unfinished transfers, aborted along with the provider
+    QVector<QPointer<KJob>> runningJobs;
+
+    QImage image;
+    bool imageCached = false;
+    QSharedPointer<QTemporaryFile> imageFile;
+
+    // the engine destroys the provider once it finished, which would abort the recent days
+    int pendingRecentImages = 0;
+    std::function<void()> deferredOutcome;
+
+    QStringList conditionalHeaders( const QUrl &url, const QString &identifier ) const;
+    void prepareConditionalJob( PotdProvider *q, KIO::TransferJob *job, const QUrl &url, const QStringList &headers );
+    void rememberValidators( KIO::TransferJob *job );
+    void storeValidators( const QString &identifier, bool pictureReplaced );
+    void settle( const std::function<void()> &outcome );
+    void recentImageDone();
 };
 
+QStringList PotdProviderPrivate::conditionalHeaders( const QUrl &url, const QString &identifier ) const
+{
+    QStringList headers;
+    if ( !QFile::exists( cacheDir() + identifier ) ) {
+        return headers;
+    }
+
+    QSettings settings(cacheDir() + QLatin1String("validators"), QSettings::IniFormat);
+    settings.beginGroup(validatorsGroup(url));
+    const QString eTag = settings.value(QStringLiteral("ETag")).toString();
+    const QString lastModified = settings.value(QStringLiteral("Last-Modified")).toString();
+    if ( !eTag.isEmpty() ) {
+        headers << QLatin1String("If-None-Match: ") + eTag;
+    }
+    if ( !lastModified.isEmpty() ) {
+        headers << QLatin1String("If-Modified-Since: ") + lastModified;
+    }
+
+    return headers;
+}
+
+void PotdProviderPrivate::prepareConditionalJob( PotdProvider *q, KIO::TransferJob *job, const QUrl &url, const QStringList &headers )
+{
+    job->addMetaData( QStringLiteral("PropagateHttpHeader"), QStringLiteral("true") );
+    if ( !headers.isEmpty() ) {
+        job->addMetaData( QStringLiteral("customHTTPHeader"), headers.join(QLatin1String("\r\n")) );
+    }
+
+    conditionalJobs.insert( job, url );
+    QObject::connect( job, &QObject::destroyed, q, [this, job] {
+        conditionalJobs.remove( job );
+    });
+
+    runningJobs.append( job );
+    QObject::connect( job, &KJob::finished, q, [this, job] {
+        runningJobs.removeAll( job );
+    });
+}
+
+void PotdProviderPrivate::rememberValidators( KIO::TransferJob *job )
+{
+    const QUrl url = conditionalJobs.value( job );
+    if ( url.isEmpty() ) {
+        return;
+    }
+
+    Validators validators;
+    const QStringList headers = job->queryMetaData( QStringLiteral("HTTP-Headers") ).split( QLatin1Char('\n') );
+    for ( const QString &header : headers ) {
+        const int colon = header.indexOf( QLatin1Char(':') );
+        if ( colon < 0 ) {
+            continue;
+        }
+        const QStringRef name = header.leftRef( colon ).trimmed();
+        if ( name.compare( QLatin1String("ETag"), Qt::CaseInsensitive ) == 0 ) {
+            validators.eTag = header.mid( colon + 1 ).trimmed();
+        } else if ( name.compare( QLatin1String("Last-Modified"), Qt::CaseInsensitive ) == 0 ) {
+            validators.lastModified = header.mid( colon + 1 ).trimmed();
+        }
+    }
+    pendingValidators.insert( url, validators );
+}
+
+void PotdProviderPrivate::storeValidators( const QString &identifier, bool pictureReplaced )
+{
+    if (pendingValidators.isEmpty()) {
+        return;
+    }
+
+    QSettings settings(cacheDir() + QLatin1String("validators"), QSettings::IniFormat);
+    for (auto it = pendingValidators.constBegin(); it != pendingValidators.constEnd(); ++it) {
+        settings.beginGroup(validatorsGroup(it.key()));
+        settings.setValue(QStringLiteral("Identifier"), identifier);
+        settings.setValue(QStringLiteral("ETag"), it.value().eTag);
+        settings.setValue(QStringLiteral("Last-Modified"), it.value().lastModified);
+        settings.endGroup();
+    }
+
+    // the urls of daily pictures change every day: once a new picture arrived, only the
+    // urls it was fetched from are of use for its identifier, and the validators of
+    // pictures gone from the cache are of no use at all. The picture of identifier
+    // itself may still be on its way to the cache of the engine
+    QSet<QString> current;
+    for (auto it = pendingValidators.constBegin(); it != pendingValidators.constEnd(); ++it) {
+        current.insert(validatorsGroup(it.key()));
+    }
+    for (const QUrl &url : qAsConst(confirmedUrls)) {
+        current.insert(validatorsGroup(url));
+    }
+    const QStringList groups = settings.childGroups();
+    for (const QString &group : groups) {
+        const QString groupIdentifier = settings.value(group + QLatin1String("/Identifier")).toString();
+        if (groupIdentifier.isEmpty()
+            || (groupIdentifier != identifier && !QFile::exists(cacheDir() + groupIdentifier))
+            || (pictureReplaced && groupIdentifier == identifier && !current.contains(group))) {
+            settings.remove(group);
+        }
+    }
+
+    pendingValidators.clear();
+    confirmedUrls.clear();
+}
+
+void PotdProviderPrivate::settle( const std::function<void()> &outcome )
+{
+    if ( pendingRecentImages > 0 ) {
+        deferredOutcome = outcome;
+    } else {
+        outcome();
+    }
+}
+
+void PotdProviderPrivate::recentImageDone()
+{
+    if ( --pendingRecentImages == 0 && deferredOutcome ) {
+        const std::function<void()> outcome = deferredOutcome;
+        deferredOutcome = nullptr;
+        outcome();
+    }
+}
+
 PotdProvider::PotdProvider( QObject *parent, const QVariantList &args )
     : QObject( parent ),
       d(new PotdProviderPrivate)
@@ -41,8 +274,14 @@ PotdProvider::PotdProvider( QObject *parent, const QVariantList &args )
 
         if ( args.count() > 1 ) {
             for (int i = 1; i < args.count(); i++) {
-                d->identifier += QStringLiteral(":") + args[i].toString();
-                QDate date = QDate::fromString(args[ i ].toString(), Qt::ISODate);
+                const QString arg = args[ i ].toString();
+                // not part of the identifier, the result is cached as the plain daily picture
+                if ( arg.startsWith( QLatin1String( "recent=" ) ) ) {
+                    d->recentDays = qMax( 0, arg.midRef( 7 ).toInt() );
+                    continue;
+                }
+                d->identifier += QStringLiteral(":") + arg;
+                QDate date = QDate::fromString(arg, Qt::ISODate);
                 if (date.isValid()) {
                     d->date = date;
                 }
@@ -52,10 +291,35 @@ PotdProvider::PotdProvider( QObject *parent, const QVariantList &args )
         d->name = QStringLiteral("Unknown");
         d->identifier = d->name;
     }
+
+    // validators are only worth keeping once the picture they belong to made it, or the
+    // cached one was confirmed, e.g. by a 304 for the image after a changed page
+    connect(this, &PotdProvider::finished, this, [this] {
+        d->storeValidators(identifier(), true);
+    });
+    connect(this, &PotdProvider::notModified, this, [this] {
+        d->storeValidators(identifier(), false);
+    });
 }
 
 PotdProvider::~PotdProvider()
 {
+    for ( const QPointer<KJob> &job : qAsConst( d->runningJobs ) ) {
+        if ( job ) {
+            job->disconnect( this );
+            job->kill();
+        }
+    }
+}
+
+QImage PotdProvider::image() const
+{
+    return d->image;
+}
+
+bool PotdProvider::isImageCached() const
+{
+    return d->imageCached;
 }
 
 QString PotdProvider::name() const
@@ -73,9 +337,189 @@ bool PotdProvider::isFixedDate() const
     return !d->date.isNull();
 }
 
+int PotdProvider::recentDays() const
+{
+    return d->recentDays;
+}
+
 QString PotdProvider::identifier() const
 {
     return d->identifier;
 }
 
+KIO::StoredTransferJob *PotdProvider::conditionalGet( const QUrl &url )
+{
+    const QStringList headers = d->conditionalHeaders( url, identifier() );
+
+    // with validators the server has to decide, not the KIO cache
+    KIO::StoredTransferJob *job = KIO::storedGet( requestUrl( url ), headers.isEmpty() ? KIO::NoReload : KIO::Reload, KIO::HideProgressInfo );
+    d->prepareConditionalJob( this, job, url, headers );
+
+    return job;
+}
+
+KIO::StoredTransferJob *PotdProvider::unconditionalGet( const QUrl &url )
+{
+    KIO::StoredTransferJob *job = KIO::storedGet( requestUrl( url ), KIO::NoReload, KIO::HideProgressInfo );
+    d->runningJobs.append( job );
+    connect( job, &KJob::finished, this, [this, job] {
+        d->runningJobs.removeAll( job );
+    });
+
+    return job;
+}
+
+bool PotdProvider::isNotModified( KIO::TransferJob *job )
+{
+    if ( job->queryMetaData( QStringLiteral("responsecode") ).toInt() == 304 ) {
+        d->confirmedUrls.insert( d->conditionalJobs.value( job ) );
+        d->conditionalJobs.remove( job );
+        return true;
+    }
+
+    if ( !job->error() ) {
+        d->rememberValidators( job );
+    }
+    d->conditionalJobs.remove( job );
+
+    return false;
+}
+
+void PotdProvider::findPageLink( const QUrl &url, const QByteArray &prefix, const QByteArray &terminator,
+                                 const std::function<void( const QByteArray &link )> &linkFound )
+{
+    const QStringList headers = d->conditionalHeaders( url, identifier() );
+
+    KIO::TransferJob *job = KIO::get( requestUrl( url ), headers.isEmpty() ? KIO::NoReload : KIO::Reload, KIO::HideProgressInfo );
+    d->prepareConditionalJob( this, job, url, headers );
+
+    auto scanner = QSharedPointer<PotdLinkScanner>::create( prefix, terminator );
+    connect( job, &KIO::TransferJob::data, this, [this, scanner, linkFound]( KIO::Job *pageJob, const QByteArray &data ) {
+        if ( data.isEmpty() || !scanner->feed( data ) ) {
+            return;
+        }
+
+        // the rest of the page is of no interest, and the image can be requested right away
+        d->rememberValidators( static_cast<KIO::TransferJob *>( pageJob ) );
+        d->conditionalJobs.remove( static_cast<KIO::TransferJob *>( pageJob ) );
+        pageJob->kill();
+        linkFound( scanner->link() );
+    });
+    connect( job, &KJob::result, this, [this]( KJob *pageJob ) {
+        // only reached when the link was not found, killing the job quietly skips this
+        if ( isNotModified( static_cast<KIO::TransferJob *>( pageJob ) ) ) {
+            emit notModified( this );
+        } else {
+            emit error( this );
+        }
+    });
+}
+
+void PotdProvider::requestPage( const QUrl &url, const std::function<void( const QByteArray &data )> &pageReceived )
+{
+    KIO::StoredTransferJob *job = conditionalGet( url );
+    connect( job, &KJob::result, this, [this, pageReceived]( KJob *pageJob ) {
+        KIO::StoredTransferJob *storedJob = static_cast<KIO::StoredTransferJob *>( pageJob );
+        if ( isNotModified( storedJob ) ) {
+            emit notModified( this );
+        } else if ( storedJob->error() || isErrorResponse( storedJob ) ) {
+            emit error( this );
+        } else {
+            pageReceived( storedJob->data() );
+        }
+    });
+}
+
+void PotdProvider::requestImage( const QUrl &url )
+{
+    const QStringList headers = d->conditionalHeaders( url, identifier() );
+
+    KIO::TransferJob *job = KIO::get( requestUrl( url ), headers.isEmpty() ? KIO::NoReload : KIO::Reload, KIO::HideProgressInfo );
+    d->prepareConditionalJob( this, job, url, headers );
+
+    // received next to the cached picture, which it only replaces once it decoded
+    QDir().mkpath( cacheDir() );
+    d->imageFile.reset( new QTemporaryFile( cacheDir() + identifier() + QLatin1String(".XXXXXX.part") ) );
+    if ( !d->imageFile->open() ) {
+        d->imageFile.reset();
+        job->kill();
+        emit error( this );
+        return;
+    }
+
+    connect( job, &KIO::TransferJob::data, this, [this]( KIO::Job *imageJob, const QByteArray &data ) {
+        if ( data.isEmpty() || !d->imageFile ) {
+            return;
+        }
+        if ( d->imageFile->write( data ) != data.size() ) {
+            d->imageFile.reset();
+            imageJob->kill( KJob::EmitResult );
+        }
+    });
+    connect( job, &KJob::result, this, [this]( KJob *imageJob ) {
+        // removed along with the last reference unless it became the cached picture
+        const QSharedPointer<QTemporaryFile> file = d->imageFile;
+        d->imageFile.reset();
+        KIO::TransferJob *transferJob = static_cast<KIO::TransferJob *>( imageJob );
+        if ( isNotModified( transferJob ) ) {
+            d->settle( [this] {
+                emit notModified( this );
+            });
+            return;
+        }
+        if ( !file || imageJob->error() || isErrorResponse( transferJob ) || !file->flush() ) {
+            emit error( this );
+            return;
+        }
+        file->close();
+
+        PotdDecodeImageThread *thread = new PotdDecodeImageThread( file->fileName() );
+        connect( thread, &PotdDecodeImageThread::done, this, [this, file]( const QImage &image ) {
+            if ( image.isNull() ) {
+                emit error( this );
+                return;
+            }
+
+            const QString path = cacheDir() + identifier();
+            QFile::remove( path );
+            if ( !file->rename( path ) ) {
+                emit error( this );
+                return;
+            }
+            file->setAutoRemove( false );
+
+            d->image = image;
+            d->imageCached = true;
+            d->settle( [this] {
+                emit finished( this );
+            });
+        });
+        QThreadPool::globalInstance()->start( thread );
+    });
+}
+
+void PotdProvider::requestRecentImage( const QUrl &url, const QDate &date )
+{
+    ++d->pendingRecentImages;
+
+    KIO::StoredTransferJob *job = unconditionalGet( url );
+    connect( job, &KJob::result, this, [this, date]( KJob *imageJob ) {
+        KIO::StoredTransferJob *storedJob = static_cast<KIO::StoredTransferJob *>( imageJob );
+        // a missing earlier day is not fatal for the current picture
+        if ( storedJob->error() || isErrorResponse( storedJob ) ) {
+            d->recentImageDone();
+            return;
+        }
+
+        PotdDecodeImageThread *thread = new PotdDecodeImageThread( storedJob->data() );
+        connect( thread, &PotdDecodeImageThread::done, this, [this, date]( const QImage &image ) {
+            if ( !image.isNull() ) {
+                emit recentImageFetched( this, date, image );
+            }
+            d->recentImageDone();
+        });
+        QThreadPool::globalInstance()->start( thread );
+    });
+}
 
+#include "potdprovider.moc"
@@ -23,10 +23,18 @@
 #include <QObject>
 #include <QVariantList>
 
+#include <functional>
+
 #include "plasma_potd_export.h"
 
 class QImage;
 class QDate;
+class QUrl;
+
+namespace KIO {
+class StoredTransferJob;
+class TransferJob;
+}
 
 /**
  * This class is an interface for PoTD providers.
@@ -54,8 +62,17 @@ class PLASMA_POTD_EXPORT PotdProvider : public QObject
          *
          * Note: This method returns only a valid image after the
          *       finished() signal has been emitted.
+         *
+         * The default implementation returns the picture fetched by
+         * requestImage().
+         */
+        virtual QImage image() const;
+
+        /**
+         * Returns whether requestImage() already wrote the picture to the
+         * cache of the engine, so it does not have to be saved once more.
          */
-        virtual QImage image() const = 0;
+        bool isImageCached() const;
 
         /**
          * Returns the identifier of the PoTD request (name + date).
@@ -77,6 +94,17 @@ class PLASMA_POTD_EXPORT PotdProvider : public QObject
          */
         bool isFixedDate() const;
 
+        /**
+         * @return the number of days, counting back from today, the provider
+         * should fetch in addition to the requested picture, or 0 if none.
+         *
+         * The engine asks for this with the "recent=<days>" argument, and only
+         * for providers which declare X-KDE-PlasmaPoTDProvider-RecentDays.
+         * Providers supporting it emit recentImageFetched() once per day
+         * before emitting finished().
+         */
+        int recentDays() const;
+
     Q_SIGNALS:
         /**
          * This signal is emitted whenever a request has been finished
@@ -93,6 +121,101 @@ class PLASMA_POTD_EXPORT PotdProvider : public QObject
          */
         void error( PotdProvider *provider );
 
+        /**
+         * This signal is emitted for every picture fetched because of
+         * recentDays(), including the one of the current day.
+         *
+         * @param provider The provider which emitted the signal.
+         * @param date The day the picture belongs to.
+         * @param image The picture of that day.
+         */
+        void recentImageFetched( PotdProvider *provider, const QDate &date, const QImage &image );
+
+        /**
+         * This signal is emitted instead of finished() when the provider
+         * found out that the cached picture is still the current one.
+         *
+         * @param provider The provider which emitted the signal.
+         */
+        void notModified( PotdProvider *provider );
+
+    protected:
+        /**
+         * Starts a GET request for @p url.
+         *
+         * While a picture for identifier() is cached, the request carries the
+         * ETag and Last-Modified validators seen the last time @p url was
+         * fetched, so an unchanged resource is answered with "304 Not Modified"
+         * and no body. A changed image url has no validators yet and is
+         * downloaded in full.
+         */
+        KIO::StoredTransferJob *conditionalGet( const QUrl &url );
+
+        /**
+         * Starts a GET request for @p url without any validators, so the
+         * resource is always received in full.
+         */
+        KIO::StoredTransferJob *unconditionalGet( const QUrl &url );
+
+        /**
+         * Returns whether @p job, started by conditionalGet(), was answered
+         * with "304 Not Modified". Providers usually emit notModified() then.
+         *
+         * Otherwise the validators of a successful response are remembered,
+         * and stored once finished() or notModified() is emitted. Once a new
+         * picture finished, the validators of urls it was not fetched from are
+         * dropped for identifier(), as are those of pictures no longer cached.
+         */
+        bool isNotModified( KIO::TransferJob *job );
+
+        /**
+         * Fetches the page at @p url, conditionally like conditionalGet(), and
+         * scans the raw bytes while they are received for the first link
+         * between @p prefix and @p terminator. The transfer is aborted as soon
+         * as the link is found, so neither the rest of the page is downloaded
+         * nor the image request delayed by it.
+         *
+         * @p linkFound is called with the bytes between prefix and terminator,
+         * otherwise error() or notModified() is emitted.
+         */
+        void findPageLink( const QUrl &url, const QByteArray &prefix, const QByteArray &terminator,
+                           const std::function<void( const QByteArray &link )> &linkFound );
+
+        /**
+         * Fetches the page at @p url, conditionally like conditionalGet().
+         *
+         * @p pageReceived is called with its content, otherwise error() or
+         * notModified() is emitted. Together with requestImage() this is the
+         * usual pipeline of a provider: request the page, parse the url of
+         * the picture out of it, request the picture.
+         */
+        void requestPage( const QUrl &url, const std::function<void( const QByteArray &data )> &pageReceived );
+
+        /**
+         * Fetches the picture at @p url, conditionally like conditionalGet(),
+         * and finishes the request with it.
+         *
+         * The picture is written to a temporary file while it is received and
+         * decoded on a worker thread from there, so neither the encoded data
+         * is kept in memory nor the GUI thread blocked. Only a picture which
+         * decodes replaces the one in the cache of the engine, an error page
+         * or a broken transfer leaves it alone. Once done, image() returns it
+         * and finished() is emitted, otherwise error() or notModified().
+         *
+         * Transfers still running when the provider is destroyed are aborted.
+         */
+        void requestImage( const QUrl &url );
+
+        /**
+         * Fetches the picture of an earlier @p date at @p url for recentDays(),
+         * decodes it on a worker thread and emits recentImageFetched() with it.
+         * A day which fails is skipped.
+         *
+         * The outcome of requestImage() is held back until all of them are done,
+         * whether the picture of today changed or not.
+         */
+        void requestRecentImage( const QUrl &url, const QDate &date );
+
     private:
         const QScopedPointer<class PotdProviderPrivate> d;
 };
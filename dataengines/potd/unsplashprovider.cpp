@@ -23,7 +23,6 @@
 #include <QRegularExpression>
 
 #include <KPluginFactory>
-#include <KIO/Job>
 
 UnsplashProvider::UnsplashProvider(QObject* parent, const QVariantList& args)
     : PotdProvider(parent, args)
@@ -38,29 +37,11 @@ UnsplashProvider::UnsplashProvider(QObject* parent, const QVariantList& args)
     }
     const QUrl url(QStringLiteral("https://source.unsplash.com/collection/%1/3840x2160/daily").arg(collectionId));
 
-    KIO::StoredTransferJob* job = KIO::storedGet(url, KIO::NoReload, KIO::HideProgressInfo);
-    connect(job, &KIO::StoredTransferJob::finished, this, &UnsplashProvider::imageRequestFinished);
+    requestImage(url);
 }
 
 UnsplashProvider::~UnsplashProvider() = default;
 
-QImage UnsplashProvider::image() const
-{
-    return mImage;
-}
-
-void UnsplashProvider::imageRequestFinished(KJob* _job)
-{
-    KIO::StoredTransferJob* job = static_cast<KIO::StoredTransferJob*>(_job);
-    if (job->error()) {
-        emit error(this);
-        return;
-    }
-    QByteArray data = job->data();
-    mImage = QImage::fromData(data);
-    emit finished(this);
-}
-
 K_PLUGIN_CLASS_WITH_JSON(UnsplashProvider, "unsplashprovider.json")
 
 #include "unsplashprovider.moc"
@@ -22,10 +22,6 @@
 
 #include "potdprovider.h"
 // Qt
-#include <QImage>
-
-class KJob;
-
 /**
  * This class provides random wallpapers from Unsplash Wallpapers
  * https://unsplash.com/wallpaper/
@@ -47,20 +43,6 @@ class UnsplashProvider : public PotdProvider
          * Destroys the Unsplash provider.
          */
         ~UnsplashProvider() override;
-
-        /**
-         * Returns the requested image.
-         *
-         * Note: This method returns only a valid image after the
-         *       finished() signal has been emitted.
-         */
-        QImage image() const override;
-
-    private:
-        void imageRequestFinished(KJob *job);
-
-    private:
-        QImage mImage;
 };
 
 #endif
@@ -24,11 +24,9 @@
 #include <QUrlQuery>
 #include <QJsonDocument>
 #include <QJsonArray>
-#include <QImage>
 #include <QDebug>
 
 #include <KPluginFactory>
-#include <KIO/Job>
 
 
 WcpotdProvider::WcpotdProvider(QObject *parent, const QVariantList &args)
@@ -42,55 +40,28 @@ WcpotdProvider::WcpotdProvider(QObject *parent, const QVariantList &args)
     urlQuery.addQueryItem(QStringLiteral("contentmodel"), QStringLiteral("wikitext"));
     urlQuery.addQueryItem(QStringLiteral("prop"), QStringLiteral("images"));
     urlQuery.addQueryItem(QStringLiteral("format"), QStringLiteral("json"));
+    // unescaped UTF-8 and no extra whitespace, which the link scanner relies on
+    urlQuery.addQueryItem(QStringLiteral("formatversion"), QStringLiteral("2"));
     url.setQuery(urlQuery);
 
-    KIO::StoredTransferJob *job = KIO::storedGet(url, KIO::NoReload, KIO::HideProgressInfo);
-    connect(job, &KIO::StoredTransferJob::finished, this, &WcpotdProvider::pageRequestFinished);
+    findPageLink(url, QByteArrayLiteral("\"images\":[\""), QByteArrayLiteral("\""), [this](const QByteArray &link) {
+        pageLinkFound(link);
+    });
 }
 
 WcpotdProvider::~WcpotdProvider() = default;
 
-QImage WcpotdProvider::image() const
+void WcpotdProvider::pageLinkFound(const QByteArray &link)
 {
-    return mImage;
-}
-
-void WcpotdProvider::pageRequestFinished(KJob *_job)
-{
-    KIO::StoredTransferJob *job = static_cast<KIO::StoredTransferJob *>( _job );
-    if ( job->error() ) {
-	emit error(this);
-	return;
-    }
-
-    auto jsonImageArray = QJsonDocument::fromJson(job->data())
-        .object().value(QLatin1String("parse"))
-        .toObject().value(QLatin1String("images"))
-        .toArray();
-
-    if (jsonImageArray.size() > 0) {
-        const QString imageFile = jsonImageArray.at(0).toString();
-        if (!imageFile.isEmpty()) {
-            const QUrl picUrl(QLatin1String("https://commons.wikimedia.org/wiki/Special:FilePath/") + imageFile);
-            KIO::StoredTransferJob *imageJob = KIO::storedGet( picUrl, KIO::NoReload, KIO::HideProgressInfo );
-            connect(imageJob, &KIO::StoredTransferJob::finished, this, &WcpotdProvider::imageRequestFinished);
-            return;
-        }
+    // the link is the content of a JSON string, let the parser undo any escaping
+    const QString imageFile = QJsonDocument::fromJson("[\"" + link + "\"]").array().at(0).toString();
+    if (imageFile.isEmpty()) {
+        emit error(this);
+        return;
     }
 
-    emit error(this);
-}
-
-void WcpotdProvider::imageRequestFinished(KJob *_job)
-{
-    KIO::StoredTransferJob *job = static_cast<KIO::StoredTransferJob *>( _job );
-    if ( job->error() ) {
-	emit error(this);
-	return;
-    }
-    QByteArray data = job->data();
-    mImage = QImage::fromData( data );
-    emit finished(this);
+    const QUrl picUrl(QLatin1String("https://commons.wikimedia.org/wiki/Special:FilePath/") + imageFile);
+    requestImage(picUrl);
 }
 
 K_PLUGIN_CLASS_WITH_JSON(WcpotdProvider, "wcpotdprovider.json")
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2020 Alexander Lohnau <alexander.lohnau@gmx.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "dictionarycache.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <atomic>
+
+namespace
+{
+const quint32 s_magic = 0x44494331; // "DIC1"
+const int s_maxEntries = 2000;
+const int s_maxAgeDays = 30;
+// the directory is only listed to evict entries every so many insertions
+const int s_trimInterval = 64;
+
+std::atomic<int> s_insertionsSinceTrim(s_trimInterval);
+
+QString cacheDirectory()
+{
+    // not the application's cache location, krunner and plasmashell share it
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/plasma_dictionary");
+}
+
+QString entryPath(const QString &dictionary, const QString &word)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(dictionary.toUtf8());
+    hash.addData("\0", 1);
+    hash.addData(word.toUtf8());
+    return cacheDirectory() + QLatin1Char('/') + QString::fromLatin1(hash.result().toHex());
+}
+
+void trim()
+{
+    QDir directory(cacheDirectory());
+    // most recently used first, entries unused for longer than they may be kept go as well
+    const QFileInfoList entries = directory.entryInfoList(QDir::Files, QDir::Time);
+    const QDateTime oldest = QDateTime::currentDateTimeUtc().addDays(-s_maxAgeDays);
+    for (int i = 0; i < entries.size(); ++i) {
+        if (i >= s_maxEntries || entries.at(i).lastModified() < oldest) {
+            QFile::remove(entries.at(i).absoluteFilePath());
+        }
+    }
+}
+}
+
+void DictionaryCache::splitSource(const QString &source, QString *dictionary, QString *word)
+{
+    const int colon = source.indexOf(QLatin1Char(':'));
+    *dictionary = colon == -1 ? QString() : source.left(colon);
+    *word = source.mid(colon + 1);
+}
+
+bool DictionaryCache::lookup(const QString &dictionary, const QString &word, QString *definition)
+{
+    QFile file(entryPath(dictionary, word));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+    quint32 magic;
+    QString entryDictionary;
+    QString entryWord;
+    QDateTime fetched;
+    stream >> magic >> entryDictionary >> entryWord >> fetched >> *definition;
+    if (stream.status() != QDataStream::Ok || magic != s_magic || entryDictionary != dictionary || entryWord != word) {
+        definition->clear();
+        return false;
+    }
+
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    if (fetched.daysTo(now) >= s_maxAgeDays) {
+        definition->clear();
+        file.remove();
+        return false;
+    }
+
+    // the modification time tells trim() which entries were used last
+    file.setFileTime(now, QFileDevice::FileModificationTime);
+    return true;
+}
+
+void DictionaryCache::insert(const QString &dictionary, const QString &word, const QString &definition)
+{
+    if (!QDir().mkpath(cacheDirectory())) {
+        return;
+    }
+
+    QSaveFile file(entryPath(dictionary, word));
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+    stream << s_magic << dictionary << word << QDateTime::currentDateTimeUtc() << definition;
+    if (stream.status() != QDataStream::Ok || !file.commit()) {
+        return;
+    }
+
+    if (++s_insertionsSinceTrim >= s_trimInterval) {
+        s_insertionsSinceTrim = 0;
+        trim();
+    }
+}
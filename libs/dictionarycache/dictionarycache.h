@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2020 Alexander Lohnau <alexander.lohnau@gmx.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef DICTIONARYCACHE_H
+#define DICTIONARYCACHE_H
+
+#include <QString>
+
+/**
+ * Definitions the dict data engine returned before, kept on disk so that
+ * looking them up again is instant and works offline.
+ *
+ * The cache is shared by the dictionary runner and the dict applet, in all
+ * processes of the user. It holds the most recently used definitions, each in
+ * a file of its own, and forgets them after a month. All functions are thread
+ * safe and do some file I/O.
+ */
+namespace DictionaryCache
+{
+/**
+ * Splits a source of the dict data engine into its dictionary, empty for the
+ * default one, and the word.
+ */
+void splitSource(const QString &source, QString *dictionary, QString *word);
+
+bool lookup(const QString &dictionary, const QString &word, QString *definition);
+void insert(const QString &dictionary, const QString &word, const QString &definition);
+}
+
+#endif
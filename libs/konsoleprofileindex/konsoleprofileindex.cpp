@@ -0,0 +1,143 @@
+/*
+ *   Copyright 2020  Alexander Lohnau <alexander.lohnau@gmx.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "konsoleprofileindex.h"
+
+// KF
+#include <KConfig>
+#include <KConfigGroup>
+#include <KDirWatch>
+// Qt
+#include <QDir>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QTimer>
+
+#include <algorithm>
+
+KonsoleProfileIndex::KonsoleProfileIndex(QObject *parent)
+    : QObject(parent)
+    , m_dirWatch(new KDirWatch(this))
+    , m_updateTimer(new QTimer(this))
+{
+    // Konsole writes a profile in several steps, look at the result only
+    m_updateTimer->setSingleShot(true);
+    m_updateTimer->setInterval(200);
+    connect(m_updateTimer, &QTimer::timeout, this, &KonsoleProfileIndex::update);
+
+    const QStringList konsoleDataBaseDirs = QStandardPaths::standardLocations(QStandardPaths::GenericDataLocation);
+    for (const QString &konsoleDataBaseDir : konsoleDataBaseDirs) {
+        m_dirWatch->addDir(konsoleDataBaseDir + QLatin1String("/konsole"));
+    }
+    auto scheduleUpdate = [this] {
+        m_updateTimer->start();
+    };
+    connect(m_dirWatch, &KDirWatch::dirty, this, scheduleUpdate);
+    connect(m_dirWatch, &KDirWatch::created, this, scheduleUpdate);
+    connect(m_dirWatch, &KDirWatch::deleted, this, scheduleUpdate);
+}
+
+KonsoleProfileIndex::~KonsoleProfileIndex() = default;
+
+QVector<KonsoleProfile> KonsoleProfileIndex::profiles() const
+{
+    QVector<KonsoleProfile> profiles;
+    profiles.reserve(m_entries.size());
+    for (const Entry &entry : m_entries) {
+        if (entry.valid) {
+            profiles.append(entry.profile);
+        }
+    }
+    std::sort(profiles.begin(), profiles.end(), [](const KonsoleProfile &a, const KonsoleProfile &b) {
+        return a.name < b.name;
+    });
+    return profiles;
+}
+
+KonsoleProfileIndex::Entry KonsoleProfileIndex::readProfile(const QString &name, const QString &path, const QDateTime &modified)
+{
+    Entry entry;
+    entry.path = path;
+    entry.modified = modified;
+
+    const KConfig config(path, KConfig::SimpleConfig);
+    if (config.hasGroup("General")) {
+        const KConfigGroup group = config.group("General");
+        entry.profile.name = name;
+        entry.profile.displayName = group.readEntry("Name", name);
+        entry.profile.iconName = group.readEntry("Icon", QStringLiteral("utilities-terminal"));
+        entry.valid = !entry.profile.displayName.isEmpty();
+    }
+    return entry;
+}
+
+void KonsoleProfileIndex::update()
+{
+    m_updateTimer->stop();
+
+    // the user's directory comes first, its profiles win
+    QHash<QString, Entry> entries;
+    const QStringList dirs = QStandardPaths::locateAll(QStandardPaths::GenericDataLocation,
+                                                       QStringLiteral("konsole"), QStandardPaths::LocateDirectory);
+    for (const QString &dir : dirs) {
+        const QFileInfoList files = QDir(dir).entryInfoList({QStringLiteral("*.profile")}, QDir::Files);
+        for (const QFileInfo &file : files) {
+            const QString name = file.baseName();
+            if (entries.contains(name)) {
+                continue;
+            }
+            const QString path = file.absoluteFilePath();
+            const QDateTime modified = file.lastModified();
+            const auto known = m_entries.constFind(name);
+            if (known != m_entries.constEnd() && known->path == path && known->modified == modified) {
+                entries.insert(name, *known);
+            } else {
+                entries.insert(name, readProfile(name, path, modified));
+            }
+        }
+    }
+
+    const QHash<QString, Entry> previousEntries = m_entries;
+    m_entries = entries;
+
+    bool changed = false;
+    for (auto it = previousEntries.constBegin(); it != previousEntries.constEnd(); ++it) {
+        if (it->valid && !entries.value(it.key()).valid) {
+            changed = true;
+            Q_EMIT profileRemoved(it.key());
+        }
+    }
+    for (auto it = entries.constBegin(); it != entries.constEnd(); ++it) {
+        if (!it->valid) {
+            continue;
+        }
+        const Entry previous = previousEntries.value(it.key());
+        if (!previous.valid) {
+            changed = true;
+            Q_EMIT profileAdded(it->profile);
+        } else if (previous.profile != it->profile) {
+            changed = true;
+            Q_EMIT profileChanged(it->profile);
+        }
+    }
+
+    if (changed) {
+        Q_EMIT profilesChanged();
+    }
+}
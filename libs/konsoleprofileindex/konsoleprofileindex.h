@@ -0,0 +1,102 @@
+/*
+ *   Copyright 2020  Alexander Lohnau <alexander.lohnau@gmx.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef KONSOLEPROFILEINDEX_H
+#define KONSOLEPROFILEINDEX_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QObject>
+#include <QVector>
+
+class KDirWatch;
+class QTimer;
+
+struct KonsoleProfile
+{
+    QString name;           // file name without extension, what "konsole --profile" takes
+    QString displayName;
+    QString iconName;
+
+    bool operator==(const KonsoleProfile &other) const
+    {
+        return name == other.name && displayName == other.displayName && iconName == other.iconName;
+    }
+    bool operator!=(const KonsoleProfile &other) const
+    {
+        return !(*this == other);
+    }
+};
+
+Q_DECLARE_TYPEINFO(KonsoleProfile, Q_MOVABLE_TYPE);
+
+/**
+ * The Konsole profiles of the user, kept up to date with the profile files.
+ *
+ * When a konsole data directory changes, only the files which appeared or have
+ * a new modification time are parsed again, and the profiles which were added,
+ * removed or changed are announced one by one. A profile of the user shadows
+ * a system one of the same name, like in Konsole.
+ *
+ * The index starts empty, connect to its signals and call update() to fill it.
+ */
+class KonsoleProfileIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit KonsoleProfileIndex(QObject *parent = nullptr);
+    ~KonsoleProfileIndex() override;
+
+    /**
+     * The known profiles, sorted by name.
+     */
+    QVector<KonsoleProfile> profiles() const;
+
+public Q_SLOTS:
+    /**
+     * Brings the index up to date with the profile files right away.
+     */
+    void update();
+
+Q_SIGNALS:
+    void profileAdded(const KonsoleProfile &profile);
+    void profileChanged(const KonsoleProfile &profile);
+    void profileRemoved(const QString &name);
+    /**
+     * Emitted once after the signals for single profiles, if there were any.
+     */
+    void profilesChanged();
+
+private:
+    struct Entry {
+        QString path;
+        QDateTime modified;
+        bool valid = false;     // files without a "General" group or name are no profiles
+        KonsoleProfile profile;
+    };
+
+    static Entry readProfile(const QString &name, const QString &path, const QDateTime &modified);
+
+    KDirWatch *m_dirWatch;
+    QTimer *m_updateTimer;
+    QHash<QString, Entry> m_entries;
+};
+
+#endif
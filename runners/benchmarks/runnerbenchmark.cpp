@@ -0,0 +1,391 @@
+/*
+ *   Copyright 2020 Alexander Lohnau <alexander.lohnau@gmx.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QMutex>
+#include <QRunnable>
+#include <QStandardPaths>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTest>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
+#include <QUrlQuery>
+
+#include <KConfig>
+#include <KConfigGroup>
+#include <KPluginFactory>
+#include <KPluginLoader>
+#include <KRunner/AbstractRunner>
+#include <KRunner/RunnerContext>
+#include <Plasma/DataEngine>
+#include <Plasma/PluginLoader>
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#include "runnerplugins.h"
+
+// Every allocation is counted for the thread making it, so the allocations
+// of a match() call can be told apart from those of the other threads.
+namespace {
+thread_local quint64 t_allocations = 0;
+}
+
+void *operator new(std::size_t size)
+{
+    ++t_allocations;
+    if (void *p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace {
+// what a round trip to the network services costs, roughly
+const int s_networkLatency = 30;
+const int s_sessionCount = 50;
+
+/**
+ * Answers the lookups of the dictionary runner in place of the dict engine
+ * of the workspace, which asks dict.org.
+ */
+class StandInDictEngine : public Plasma::DataEngine
+{
+public:
+    StandInDictEngine()
+        : Plasma::DataEngine(nullptr, QVariantList())
+    {
+    }
+
+protected:
+    bool sourceRequestEvent(const QString &word) override
+    {
+        // the runner connects to the source right away, the definition follows
+        setData(word, Plasma::DataEngine::Data());
+        QTimer::singleShot(s_networkLatency, this, [this, word] {
+            setData(word, QStringLiteral("text"),
+                    QStringLiteral("<pre>From WordNet (r) 3.0 (2006) [wn]:\n\n  %1\n"
+                                   "      n 1: a definition standing in for the real one\n"
+                                   "      2: another meaning of %1\n"
+                                   "      v 1: to stand in for %1</pre>").arg(word));
+        });
+        return true;
+    }
+};
+
+class StandInPluginLoader : public Plasma::PluginLoader
+{
+protected:
+    Plasma::DataEngine *internalLoadDataEngine(const QString &name) override
+    {
+        if (name == QLatin1String("dict")) {
+            return new StandInDictEngine;
+        }
+        return nullptr;
+    }
+};
+
+/**
+ * Answers the searches of the MediaWiki runner in place of Wikipedia.
+ */
+class StandInWikiServer : public QTcpServer
+{
+public:
+    explicit StandInWikiServer(QObject *parent)
+        : QTcpServer(parent)
+    {
+        connect(this, &QTcpServer::newConnection, this, [this] {
+            while (QTcpSocket *socket = nextPendingConnection()) {
+                connect(socket, &QTcpSocket::readyRead, this, [this, socket] {
+                    handle(socket);
+                });
+                connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+            }
+        });
+    }
+
+private:
+    void handle(QTcpSocket *socket)
+    {
+        if (!socket->canReadLine()) {
+            return;
+        }
+        const QList<QByteArray> requestLine = socket->readLine().split(' ');
+        socket->readAll();
+        if (requestLine.count() < 2) {
+            socket->disconnectFromHost();
+            return;
+        }
+
+        const QUrlQuery query(QUrl(QString::fromLatin1(requestLine.at(1))));
+        QByteArray body;
+        if (query.queryItemValue(QStringLiteral("meta")) == QLatin1String("siteinfo")) {
+            body = "<?xml version=\"1.0\"?><api><query><general base=\"http://localhost/wiki/Main_Page\"/></query></api>";
+        } else {
+            const QString term = query.queryItemValue(QStringLiteral("search"), QUrl::FullyDecoded);
+            QJsonArray titles;
+            QJsonArray urls;
+            for (int i = 1; i <= 3; ++i) {
+                titles.append(QStringLiteral("%1 %2").arg(term).arg(i));
+                urls.append(QStringLiteral("http://localhost/wiki/%1_%2").arg(term).arg(i));
+            }
+            body = QJsonDocument(QJsonArray{term, titles, QJsonArray(), urls}).toJson(QJsonDocument::Compact);
+        }
+
+        // the connection is kept open for further requests, like the wikis do
+        QTimer::singleShot(s_networkLatency, socket, [socket, body] {
+            socket->write("HTTP/1.1 200 OK\r\nContent-Type: text/xml\r\nContent-Length: "
+                          + QByteArray::number(body.size()) + "\r\n\r\n" + body);
+        });
+    }
+};
+
+struct Sample
+{
+    qint64 nsecs;
+    quint64 allocations;
+};
+
+/**
+ * Types the recorded queries into a runner, one match() per keystroke,
+ * as KRunner does while the user is typing.
+ */
+class Replay : public QRunnable
+{
+public:
+    Replay(Plasma::AbstractRunner *runner, const QStringList &typedQueries, QMutex *mutex, QVector<Sample> *samples)
+        : m_runner(runner)
+        , m_typedQueries(typedQueries)
+        , m_mutex(mutex)
+        , m_samples(samples)
+    {
+    }
+
+    void run() override
+    {
+        QVector<Sample> samples;
+        for (const QString &typed : qAsConst(m_typedQueries)) {
+            QString query;
+            for (int i = 0; i < typed.size(); ++i) {
+                if (typed.midRef(i, 2) == QLatin1String("\\b")) {
+                    query.chop(1);
+                    ++i;
+                } else {
+                    query += typed.at(i);
+                }
+
+                Plasma::RunnerContext context;
+                context.setQuery(query);
+
+                const quint64 allocations = t_allocations;
+                QElapsedTimer timer;
+                timer.start();
+                m_runner->match(context);
+                samples.append({timer.nsecsElapsed(), t_allocations - allocations});
+            }
+        }
+
+        QMutexLocker locker(m_mutex);
+        *m_samples += samples;
+    }
+
+private:
+    Plasma::AbstractRunner *m_runner;
+    QStringList m_typedQueries;
+    QMutex *m_mutex;
+    QVector<Sample> *m_samples;
+};
+
+QString milliseconds(qint64 nsecs)
+{
+    return QString::number(nsecs / 1000000.0, 'f', 2);
+}
+}
+
+class RunnerBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void benchmark_data();
+    void benchmark();
+
+private:
+    Plasma::AbstractRunner *loadRunner(const QString &plugin);
+
+    QHash<QString, QStringList> m_typedQueries;
+    StandInWikiServer *m_wikiServer = nullptr;
+};
+
+void RunnerBenchmark::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    QLocale::setDefault(QLocale::English);
+
+    QFile keystrokes(QStringLiteral(KEYSTROKES_FILE));
+    QVERIFY(keystrokes.open(QIODevice::ReadOnly | QIODevice::Text));
+    while (!keystrokes.atEnd()) {
+        const QString line = QString::fromUtf8(keystrokes.readLine()).remove(QLatin1Char('\n'));
+        const int tab = line.indexOf(QLatin1Char('\t'));
+        if (line.startsWith(QLatin1Char('#')) || tab < 0) {
+            continue;
+        }
+        m_typedQueries[line.left(tab)].append(line.mid(tab + 1));
+    }
+
+    // something to find for the runners listing local files
+    const QString dataDir = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation);
+    QVERIFY(QDir().mkpath(dataDir + QStringLiteral("/kate/sessions")));
+    QVERIFY(QDir().mkpath(dataDir + QStringLiteral("/konsole")));
+    for (int i = 0; i < s_sessionCount; ++i) {
+        QFile session(dataDir + QStringLiteral("/kate/sessions/project session %1.katesession").arg(i));
+        QVERIFY(session.open(QIODevice::WriteOnly));
+
+        KConfig profile(dataDir + QStringLiteral("/konsole/profile%1.profile").arg(i), KConfig::SimpleConfig);
+        profile.group("General").writeEntry("Name", QStringLiteral("Profile %1").arg(i));
+    }
+
+    Plasma::PluginLoader::setPluginLoader(new StandInPluginLoader);
+
+    m_wikiServer = new StandInWikiServer(this);
+    QVERIFY(m_wikiServer->listen(QHostAddress::LocalHost));
+    qputenv("PLASMA_MEDIAWIKI_TEST_API_URL", QStringLiteral("http://127.0.0.1:%1/w/api.php").arg(m_wikiServer->serverPort()).toLatin1());
+}
+
+Plasma::AbstractRunner *RunnerBenchmark::loadRunner(const QString &plugin)
+{
+    QString fileName = plugin;
+    for (auto built = s_builtPlugins; built->name; ++built) {
+        if (plugin == QLatin1String(built->name)) {
+            fileName = QString::fromLocal8Bit(built->path);
+        }
+    }
+
+    KPluginLoader loader(fileName);
+    KPluginFactory *factory = loader.factory();
+    return factory ? factory->create<Plasma::AbstractRunner>(this, QVariantList()) : nullptr;
+}
+
+void RunnerBenchmark::benchmark_data()
+{
+    QTest::addColumn<QString>("plugin");
+
+    QTest::newRow("converter") << QStringLiteral("krunner_converter");
+    QTest::newRow("datetime") << QStringLiteral("krunner_datetime");
+    QTest::newRow("spellchecker") << QStringLiteral("krunner_spellcheck");
+    QTest::newRow("characters") << QStringLiteral("krunner_charrunner");
+    QTest::newRow("katesessions") << QStringLiteral("krunner_katesessions");
+    QTest::newRow("konsoleprofiles") << QStringLiteral("krunner_konsoleprofiles");
+    QTest::newRow("dictionary") << QStringLiteral("krunner_dictionary");
+    QTest::newRow("mediawiki") << QStringLiteral("krunner_mediawiki");
+}
+
+void RunnerBenchmark::benchmark()
+{
+    QFETCH(QString, plugin);
+
+    QElapsedTimer timer;
+    timer.start();
+    Plasma::AbstractRunner *runner = loadRunner(plugin);
+    if (!runner) {
+        QSKIP("runner plugin not found");
+    }
+    QMetaObject::invokeMethod(runner, "init", Qt::DirectConnection);
+    const qint64 initCost = timer.nsecsElapsed();
+
+    timer.restart();
+    emit runner->prepare();
+    const qint64 prepareCost = timer.nsecsElapsed();
+
+    // several threads typing at once, like KRunner matching the queries of a fast typist in parallel
+    QThreadPool pool;
+    const int threads = qBound(2, QThread::idealThreadCount(), 4);
+    pool.setMaxThreadCount(threads);
+    QMutex mutex;
+    QVector<Sample> samples;
+    for (int i = 0; i < threads; ++i) {
+        pool.start(new Replay(runner, m_typedQueries.value(plugin), &mutex, &samples));
+    }
+    // the runners waiting for the GUI thread, like the dictionary, need its event loop
+    while (!pool.waitForDone(1)) {
+        QCoreApplication::processEvents();
+    }
+
+    emit runner->teardown();
+    delete runner;
+
+    QVERIFY(!samples.isEmpty());
+    std::sort(samples.begin(), samples.end(), [](const Sample &a, const Sample &b) {
+        return a.nsecs < b.nsecs;
+    });
+    auto percentile = [&samples](int p) {
+        return samples.at(qMin(samples.size() - 1, samples.size() * p / 100)).nsecs;
+    };
+    quint64 allocations = 0;
+    for (const Sample &sample : qAsConst(samples)) {
+        allocations += sample.allocations;
+    }
+
+    qInfo().noquote() << QStringLiteral("%1: init %2 ms, prepare %3 ms; %4 matches on %5 threads: "
+                                        "p50 %6 ms, p90 %7 ms, p99 %8 ms, max %9 ms, %10 allocations per match")
+                         .arg(QString::fromLatin1(QTest::currentDataTag()), milliseconds(initCost), milliseconds(prepareCost))
+                         .arg(samples.size()).arg(threads)
+                         .arg(milliseconds(percentile(50)), milliseconds(percentile(90)), milliseconds(percentile(99)),
+                              milliseconds(samples.last().nsecs))
+                         .arg(allocations / samples.size());
+
+    QTest::setBenchmarkResult(percentile(90) / 1000000.0, QTest::WalltimeMilliseconds);
+}
+
+QTEST_MAIN(RunnerBenchmark)
+
+#include "runnerbenchmark.moc"
@@ -0,0 +1,235 @@
+/* Copyright 2020  Alexander Lohnau <alexander.lohnau@gmx.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "characternames.h"
+
+#include <QHash>
+#include <QtEndian>
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+namespace
+{
+constexpr quint32 s_headerSize = 5;
+constexpr quint32 s_maxSeedPostings = 8192;
+
+enum WordMatch {
+    NoMatch,
+    PrefixMatch,
+    WholeWordMatch,
+};
+
+bool isSeparator(char c)
+{
+    return c == ' ' || c == '-' || c == '\0';
+}
+
+// how well one of the words of the name fits the typed word
+WordMatch matchWord(const char *name, const QByteArray &word)
+{
+    WordMatch best = NoMatch;
+    for (const char *start = name; *start; ++start) {
+        if ((start == name || isSeparator(start[-1])) && std::strncmp(start, word.constData(), word.size()) == 0) {
+            if (isSeparator(start[word.size()])) {
+                return WholeWordMatch;
+            }
+            best = PrefixMatch;
+        }
+    }
+    return best;
+}
+
+int wordCount(const char *name)
+{
+    int count = 1;
+    for (; *name; ++name) {
+        count += isSeparator(*name);
+    }
+    return count;
+}
+}
+
+CharacterNames::CharacterNames(const QByteArray &index)
+    : m_index(index)
+{
+    if (quint32(m_index.size()) < s_headerSize * 4 || number(0) != Magic) {
+        return;
+    }
+    const quint32 entryCount = number(1);
+    const quint32 wordCount = number(2);
+    const quint32 postingCount = number(3);
+    const quint32 stringSize = number(4);
+
+    const quint64 numbers = quint64(s_headerSize) + 2 * quint64(entryCount) + 3 * quint64(wordCount) + postingCount;
+    if (numbers * 4 + stringSize != quint64(m_index.size()) || stringSize == 0 || m_index.at(m_index.size() - 1) != '\0') {
+        return;
+    }
+    m_entryCount = entryCount;
+    m_wordCount = wordCount;
+    m_wordsStart = s_headerSize + 2 * entryCount;
+    m_postingsStart = m_wordsStart + 3 * wordCount;
+    m_stringsStart = (m_postingsStart + postingCount) * 4;
+}
+
+bool CharacterNames::isValid() const
+{
+    return m_entryCount > 0;
+}
+
+quint32 CharacterNames::number(quint32 position) const
+{
+    return qFromLittleEndian<quint32>(m_index.constData() + 4 * position);
+}
+
+const char *CharacterNames::string(quint32 offset) const
+{
+    return m_index.constData() + m_stringsStart + offset;
+}
+
+QPair<quint32, quint32> CharacterNames::wordsStartingWith(const QByteArray &prefix) const
+{
+    auto wordAt = [this](quint32 word) {
+        return string(number(m_wordsStart + 3 * word));
+    };
+
+    quint32 first = 0;
+    quint32 count = m_wordCount;
+    while (count > 0) {
+        const quint32 step = count / 2;
+        if (std::strcmp(wordAt(first + step), prefix.constData()) < 0) {
+            first += step + 1;
+            count -= step + 1;
+        } else {
+            count = step;
+        }
+    }
+    quint32 last = first;
+    while (last < m_wordCount && std::strncmp(wordAt(last), prefix.constData(), prefix.size()) == 0) {
+        ++last;
+    }
+    return {first, last};
+}
+
+QVector<CharacterNames::Character> CharacterNames::find(const QString &term, int limit) const
+{
+    QVector<Character> characters;
+    if (!isValid()) {
+        return characters;
+    }
+
+    QVector<QByteArray> words;
+    QByteArray typedWord;
+    for (const QChar c : term + QLatin1Char(' ')) {
+        if (c.isSpace() || c == QLatin1Char('-')) {
+            if (!typedWord.isEmpty()) {
+                words.append(typedWord);
+                typedWord.clear();
+            }
+        } else if (c.unicode() < 128) {
+            typedWord.append(c.toUpper().toLatin1());
+        } else {
+            return characters; // names are plain ASCII
+        }
+    }
+    if (words.isEmpty()) {
+        return characters;
+    }
+
+    // the entries of the typed word with the fewest postings are checked against the others
+    QPair<quint32, quint32> seedWords;
+    quint32 seedPostings = UINT_MAX;
+    for (const QByteArray &word : qAsConst(words)) {
+        const QPair<quint32, quint32> range = wordsStartingWith(word);
+        quint32 postings = 0;
+        for (quint32 i = range.first; i < range.second; ++i) {
+            postings += number(m_wordsStart + 3 * i + 2);
+        }
+        if (postings < seedPostings) {
+            seedWords = range;
+            seedPostings = postings;
+        }
+    }
+    // a letter or two are part of too many names to list them
+    if (seedPostings == 0 || seedPostings > s_maxSeedPostings) {
+        return characters;
+    }
+
+    QVector<quint32> entries;
+    entries.reserve(seedPostings);
+    for (quint32 i = seedWords.first; i < seedWords.second; ++i) {
+        const quint32 firstPosting = number(m_wordsStart + 3 * i + 1);
+        const quint32 postingCount = number(m_wordsStart + 3 * i + 2);
+        for (quint32 posting = firstPosting; posting < firstPosting + postingCount; ++posting) {
+            entries.append(number(m_postingsStart + posting));
+        }
+    }
+    std::sort(entries.begin(), entries.end());
+    entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+
+    int termLength = 0;
+    for (const QByteArray &word : qAsConst(words)) {
+        termLength += word.size();
+    }
+
+    QHash<uint, int> characterIndices;
+    for (const quint32 entry : qAsConst(entries)) {
+        if (entry >= m_entryCount) {
+            continue;
+        }
+        const char *name = string(number(s_headerSize + 2 * entry + 1));
+        bool wholeWords = true;
+        bool matches = true;
+        for (const QByteArray &word : qAsConst(words)) {
+            const WordMatch wordMatch = matchWord(name, word);
+            matches = matches && wordMatch != NoMatch;
+            wholeWords = wholeWords && wordMatch == WholeWordMatch;
+        }
+        if (!matches) {
+            continue;
+        }
+
+        const int nameLength = int(std::strlen(name));
+        qreal score;
+        if (wholeWords && wordCount(name) == words.size()) {
+            score = 1;
+        } else {
+            score = (wholeWords ? 0.8 : 0.6) + 0.19 * termLength / nameLength;
+        }
+
+        // a character found by several of its names is listed once, with the best one
+        const uint code = number(s_headerSize + 2 * entry);
+        const auto known = characterIndices.constFind(code);
+        if (known == characterIndices.constEnd()) {
+            characterIndices.insert(code, characters.size());
+            characters.append({code, QString::fromLatin1(name, nameLength), score});
+        } else if (characters.at(*known).score < score) {
+            characters[*known] = {code, QString::fromLatin1(name, nameLength), score};
+        }
+    }
+
+    std::sort(characters.begin(), characters.end(), [](const Character &a, const Character &b) {
+        return a.score > b.score || (a.score == b.score && a.code < b.code);
+    });
+    if (characters.size() > limit) {
+        characters.resize(limit);
+    }
+    return characters;
+}
@@ -0,0 +1,80 @@
+/* Copyright 2020  Alexander Lohnau <alexander.lohnau@gmx.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CHARACTERNAMES_H
+#define CHARACTERNAMES_H
+
+#include <QByteArray>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+/**
+ * Looks characters up by their Unicode name, "snowman" or "arrow right".
+ *
+ * The index is generated from the Unicode Character Database when building,
+ * by ucdindexgen, and read in place. It consists of little endian 32 bit
+ * numbers:
+ *
+ *     magic, entry count, word count, posting count, string size
+ *     per entry: code point, name           sorted by code point
+ *     per word: word, first posting, posting count   sorted by word
+ *     postings: entry indices               ascending for each word
+ *     strings: upper case ASCII, NUL terminated, names and words point at them
+ *
+ * A character can have several entries, for its name and its aliases.
+ */
+class CharacterNames
+{
+public:
+    enum {
+        Magic = 0x3144434b, // "KCD1"
+    };
+
+    struct Character {
+        uint code;
+        QString name;
+        qreal score;
+    };
+
+    explicit CharacterNames(const QByteArray &index);
+
+    bool isValid() const;
+
+    /**
+     * Returns the characters having a word starting with each of the words in
+     * @p term, best first: those named exactly so, then those containing the
+     * words as a whole, preferring shorter names.
+     */
+    QVector<Character> find(const QString &term, int limit) const;
+
+private:
+    quint32 number(quint32 position) const;
+    const char *string(quint32 offset) const;
+    QPair<quint32, quint32> wordsStartingWith(const QByteArray &prefix) const;
+
+    QByteArray m_index;
+    quint32 m_entryCount = 0;
+    quint32 m_wordCount = 0;
+    quint32 m_wordsStart = 0;
+    quint32 m_postingsStart = 0;
+    quint32 m_stringsStart = 0;
+};
+
+#endif
@@ -28,6 +28,9 @@
 #include <QGuiApplication>
 #include <QDebug>
 #include <QClipboard>
+#include <QFile>
+
+static const int s_maxNameMatches = 10;
 
 CharacterRunner::CharacterRunner(QObject *parent, const QVariantList &args)
     : Plasma::AbstractRunner(parent, args)
@@ -55,14 +58,16 @@ void CharacterRunner::reloadConfiguration()
         m_codes.clear();
         qWarning() << "Config entries for alias list and code list have different sizes, ignoring all.";
     }
+    m_aliasMatcher.setItems(m_aliases);
 
     addSyntax(Plasma::RunnerSyntax(m_triggerWord + QStringLiteral(":q:"),
-                                   i18n("Creates Characters from :q: if it is a hexadecimal code or defined alias.")));
+                                   i18n("Creates Characters from :q: if it is a hexadecimal code, a defined alias or a character name.")));
 }
 
 void CharacterRunner::match(Plasma::RunnerContext &context)
 {
-    QString term = context.query().remove(QLatin1Char(' '));
+    const QString query = context.query();
+    QString term = QString(query).remove(QLatin1Char(' '));
 
     if (term.length() < 2 || !term.startsWith(m_triggerWord) || !context.isValid()) {
         return;
@@ -70,24 +75,71 @@ void CharacterRunner::match(Plasma::RunnerContext &context)
 
     term = term.remove(0, m_triggerWord.length()); //remove the triggerword
 
-    //replace aliases by their hex.-code
-    if (m_aliases.contains(term)) {
-        term = m_codes[m_aliases.indexOf(term)];
+    //an alias typed out replaces its hex.-code, otherwise offer the aliases looking alike
+    const int alias = m_aliases.indexOf(term);
+    if (alias != -1) {
+        addCharacterMatch(context, m_codes.at(alias), QString(), Plasma::QueryMatch::ExactMatch, 1);
+        return;
+    }
+
+    addCharacterMatch(context, term, QString(), Plasma::QueryMatch::ExactMatch, 1);
+    if (term.isEmpty()) {
+        return;
     }
+    const auto aliasMatches = m_aliasMatcher.match(term);
+    for (const FuzzyMatcher::Match &aliasMatch : aliasMatches) {
+        addCharacterMatch(context, m_codes.at(aliasMatch.index), m_aliases.at(aliasMatch.index),
+                          Plasma::QueryMatch::PossibleMatch, aliasMatch.score * 0.9);
+    }
+
+    //look the words up in the character names, "# arrow right"
+    if (query.startsWith(m_triggerWord)) {
+        const QString name = query.mid(m_triggerWord.length());
+        const auto characters = characterNames().find(name, s_maxNameMatches);
+        for (const CharacterNames::Character &character : characters) {
+            addCharacterMatch(context, character.code, character.name.toLower(),
+                              Plasma::QueryMatch::PossibleMatch, character.score * 0.8);
+        }
+    }
+}
 
+const CharacterNames &CharacterRunner::characterNames()
+{
+    // the index is compiled in if the Unicode Character Database was found when building
+    static const CharacterNames names([] {
+        QFile index(QStringLiteral(":/charrunner/characternames.index"));
+        return index.open(QIODevice::ReadOnly) ? index.readAll() : QByteArray();
+    }());
+    return names;
+}
+
+void CharacterRunner::addCharacterMatch(Plasma::RunnerContext &context, const QString &code, const QString &alias,
+                                        Plasma::QueryMatch::Type type, qreal relevance)
+{
     bool ok;
-    int hex = term.toInt(&ok, 16); //convert query into int
-    if (!ok) {
+    const uint hex = code.toUInt(&ok, 16); //convert query into int
+    if (ok) {
+        addCharacterMatch(context, hex, alias, type, relevance);
+    }
+}
+
+void CharacterRunner::addCharacterMatch(Plasma::RunnerContext &context, uint code, const QString &name,
+                                        Plasma::QueryMatch::Type type, qreal relevance)
+{
+    if (code > QChar::LastValidCodePoint || QChar::isSurrogate(code)) {
         return;
     }
 
-    //make special character out of the hex.-code
-    const QString specChar = QChar(hex);
+    //make special character out of the code point, characters beyond the BMP take two QChars
+    const QString specChar = QString::fromUcs4(&code, 1);
     Plasma::QueryMatch match(this);
-    match.setType(Plasma::QueryMatch::ExactMatch);
+    match.setType(type);
     match.setIconName(QStringLiteral("accessories-character-map"));
     match.setText(specChar);
+    match.setSubtext(name.isEmpty() ? QString() : i18nc("character name (code point)", "%1 (U+%2)",
+                                                        name, QString::number(code, 16).toUpper().rightJustified(4, QLatin1Char('0'))));
     match.setData(specChar);
+    match.setRelevance(relevance);
     context.addMatch(match);
 }
 
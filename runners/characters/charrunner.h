@@ -22,6 +22,10 @@
 #define CHARRUNNER_H
 
 #include <KRunner/AbstractRunner>
+#include <KRunner/QueryMatch>
+
+#include "characternames.h"
+#include "fuzzymatcher.h"
 
 class CharacterRunner : public Plasma::AbstractRunner
 {
@@ -36,10 +40,17 @@ class CharacterRunner : public Plasma::AbstractRunner
     void run(const Plasma::RunnerContext &context, const Plasma::QueryMatch &match) override;
 
   private:
+    static const CharacterNames &characterNames();
+    void addCharacterMatch(Plasma::RunnerContext &context, const QString &code, const QString &alias,
+                           Plasma::QueryMatch::Type type, qreal relevance);
+    void addCharacterMatch(Plasma::RunnerContext &context, uint code, const QString &name,
+                           Plasma::QueryMatch::Type type, qreal relevance);
+
     //config-variables
     QString m_triggerWord;
     QList<QString> m_aliases;
     QList<QString> m_codes;
+    FuzzyMatcher m_aliasMatcher;
 };
 
 #endif
@@ -0,0 +1,163 @@
+/* Copyright 2020  Alexander Lohnau <alexander.lohnau@gmx.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Builds the character name index of the runner from the Unicode Character Database:
+ *
+ *     ucdindexgen <index> <UnicodeData.txt> [NameAliases.txt]
+ *
+ * The index is a sequence of little endian 32 bit numbers, see characternames.h
+ * for its layout.
+ */
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QFile>
+#include <QMap>
+#include <QSaveFile>
+#include <QVector>
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+
+#include "characternames.h"
+
+namespace
+{
+struct Name {
+    quint32 code;
+    QByteArray name;
+};
+
+bool readLines(const char *path, const std::function<void(const QList<QByteArray> &fields)> &handleFields)
+{
+    QFile file(QFile::decodeName(path));
+    if (!file.open(QIODevice::ReadOnly)) {
+        std::fprintf(stderr, "ucdindexgen: cannot read %s\n", path);
+        return false;
+    }
+    while (!file.atEnd()) {
+        QByteArray line = file.readLine();
+        const int comment = line.indexOf('#');
+        if (comment != -1) {
+            line.truncate(comment);
+        }
+        line = line.trimmed();
+        if (!line.isEmpty()) {
+            handleFields(line.split(';'));
+        }
+    }
+    return true;
+}
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        std::fprintf(stderr, "usage: ucdindexgen <index> <UnicodeData.txt> [NameAliases.txt]\n");
+        return 1;
+    }
+
+    QVector<Name> names;
+    auto addName = [&names](const QByteArray &code, const QByteArray &name) {
+        bool ok;
+        const quint32 codePoint = code.toUInt(&ok, 16);
+        // ranges like "<CJK Ideograph, First>" and "<control>" have no name of their own
+        if (ok && !name.isEmpty() && !name.startsWith('<')) {
+            names.append({codePoint, name.toUpper()});
+        }
+    };
+
+    const bool ok = readLines(argv[2], [&addName](const QList<QByteArray> &fields) {
+        if (fields.size() > 10) {
+            addName(fields.at(0), fields.at(1));
+            // the Unicode 1.0 name, like "LINE FEED" for U+000A
+            addName(fields.at(0), fields.at(10));
+        }
+    });
+    if (!ok || (argc > 3 && !readLines(argv[3], [&addName](const QList<QByteArray> &fields) {
+        if (fields.size() > 2 && fields.at(2) != "figment") {
+            addName(fields.at(0), fields.at(1));
+        }
+    }))) {
+        return 1;
+    }
+
+    // the names of a character stay in their order, the official one first
+    std::stable_sort(names.begin(), names.end(), [](const Name &a, const Name &b) {
+        return a.code < b.code;
+    });
+    names.erase(std::unique(names.begin(), names.end(), [](const Name &a, const Name &b) {
+        return a.code == b.code && a.name == b.name;
+    }), names.end());
+
+    QByteArray strings;
+    QMap<QByteArray, quint32> stringOffsets;
+    auto addString = [&strings, &stringOffsets](const QByteArray &string) {
+        auto it = stringOffsets.constFind(string);
+        if (it == stringOffsets.constEnd()) {
+            it = stringOffsets.insert(string, strings.size());
+            strings.append(string);
+            strings.append('\0');
+        }
+        return *it;
+    };
+
+    QVector<quint32> entries;
+    QMap<QByteArray, QVector<quint32>> words; // sorted like the runner compares them
+    for (int i = 0; i < names.size(); ++i) {
+        entries << names.at(i).code << addString(names.at(i).name);
+        QByteArray word;
+        for (const char c : names.at(i).name + ' ') {
+            if (c == ' ' || c == '-') {
+                if (!word.isEmpty() && (words[word].isEmpty() || words[word].constLast() != quint32(i))) {
+                    words[word].append(i);
+                }
+                word.clear();
+            } else {
+                word.append(c);
+            }
+        }
+    }
+
+    QVector<quint32> wordTable;
+    QVector<quint32> postings;
+    for (auto it = words.constBegin(); it != words.constEnd(); ++it) {
+        wordTable << addString(it.key()) << postings.size() << it->size();
+        postings << *it;
+    }
+
+    QSaveFile index(QFile::decodeName(argv[1]));
+    if (!index.open(QIODevice::WriteOnly)) {
+        std::fprintf(stderr, "ucdindexgen: cannot write %s\n", argv[1]);
+        return 1;
+    }
+    QDataStream stream(&index);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream << quint32(CharacterNames::Magic) << quint32(names.size()) << quint32(words.size())
+           << quint32(postings.size()) << quint32(strings.size());
+    for (const QVector<quint32> *table : {&entries, &wordTable, &postings}) {
+        for (const quint32 value : *table) {
+            stream << value;
+        }
+    }
+    index.write(strings);
+    return index.commit() ? 0 : 1;
+}
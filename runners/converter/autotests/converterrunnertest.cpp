@@ -18,7 +18,14 @@
  *   License along with this library.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
 #include <QTest>
+#include <QUrl>
 
 #include "../converterrunner.h"
 
@@ -26,6 +33,15 @@
 
 using namespace KUnitConversion;
 
+namespace {
+// only valid once the test mode of QStandardPaths is enabled
+QString compatibleUnitsPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+        + QStringLiteral("/krunner_converter/compatibleunits");
+}
+}
+
 class ConverterRunnerTest : public QObject
 {
 Q_OBJECT
@@ -43,16 +59,78 @@ private Q_SLOTS:
     void testInvalidFractions();
     void testSymbolsInUnits();
     void testNegativeValue();
+    void testUnitCompletion();
+    void testMistypedUnitCompletion();
+    void testStaleCurrencyRates();
+    void testCompatibleUnitsCache();
 
 private:
+    void installCurrencyRates(const QDateTime &fetched);
+    void readCompatibleUnits(QString *key, QMap<QString, QString> *units);
+    void writeCompatibleUnits(const QString &key, const QMap<QString, QString> &units);
+
     ConverterRunner *runner = nullptr;
 };
 
+/**
+ * Provides the exchange rates, so that no conversion depends on the network
+ */
+void ConverterRunnerTest::installCurrencyRates(const QDateTime &fetched)
+{
+    const QString path = QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+        + QStringLiteral("/krunner_converter/currency.xml");
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QFile::remove(path);
+    QVERIFY(QFile::copy(QFINDTESTDATA("currency.xml"), path));
+
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.setFileTime(fetched, QFileDevice::FileModificationTime));
+}
+
+/**
+ * The table of unit aliases persisted by the runner
+ */
+void ConverterRunnerTest::readCompatibleUnits(QString *key, QMap<QString, QString> *units)
+{
+    QFile file(compatibleUnitsPath());
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+    quint32 magic;
+    stream >> magic >> *key >> *units;
+    QCOMPARE(stream.status(), QDataStream::Ok);
+}
+
+void ConverterRunnerTest::writeCompatibleUnits(const QString &key, const QMap<QString, QString> &units)
+{
+    QFile file(compatibleUnitsPath());
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_12);
+    quint32 magic;
+    in >> magic;
+    file.close();
+
+    QSaveFile saveFile(compatibleUnitsPath());
+    QVERIFY(saveFile.open(QIODevice::WriteOnly));
+    QDataStream out(&saveFile);
+    out.setVersion(QDataStream::Qt_5_12);
+    out << magic << key << units;
+    QVERIFY(saveFile.commit());
+}
+
 void ConverterRunnerTest::initTestCase()
 {
     setlocale(LC_ALL, "C.utf8");
     qputenv("LANG", "en_US");
     QLocale::setDefault(QLocale::English);
+    QStandardPaths::setTestModeEnabled(true);
+    // refreshing the exchange rates fails right away instead of asking the bank
+    qputenv("KRUNNER_CONVERTER_RATES_URL",
+            QUrl::fromLocalFile(QDir::currentPath() + QStringLiteral("/no-such-rates.xml")).toEncoded());
+    installCurrencyRates(QDateTime::currentDateTime());
+    QFile::remove(compatibleUnitsPath());
     runner = new ConverterRunner(this, QVariantList());
     runner->init();
 }
@@ -212,6 +290,97 @@ void ConverterRunnerTest::testNegativeValue()
     QCOMPARE(context.matches().first().text(), "-400 centimeters (cm)");
 }
 
+/**
+ * Test if a partially typed target unit is completed
+ */
+void ConverterRunnerTest::testUnitCompletion()
+{
+    Plasma::RunnerContext context;
+    context.setQuery(QStringLiteral("1m > centim"));
+    runner->match(context);
+
+    QCOMPARE(context.matches().count(), 1);
+    QCOMPARE(context.matches().first().text(), QStringLiteral("100 centimeters (cm)"));
+}
+
+/**
+ * Test if a mistyped target unit is still completed
+ */
+void ConverterRunnerTest::testMistypedUnitCompletion()
+{
+    Plasma::RunnerContext context;
+    context.setQuery(QStringLiteral("1m > cnetim"));
+    runner->match(context);
+
+    QCOMPARE(context.matches().count(), 1);
+    QCOMPARE(context.matches().first().text(), QStringLiteral("100 centimeters (cm)"));
+}
+
+/**
+ * Test if conversions with old exchange rates are answered, but marked
+ */
+void ConverterRunnerTest::testStaleCurrencyRates()
+{
+    Plasma::RunnerContext context;
+    context.setQuery(QStringLiteral("100 usd > eur"));
+    runner->match(context);
+    QCOMPARE(context.matches().count(), 1);
+    QVERIFY(context.matches().first().subtext().isEmpty());
+
+    installCurrencyRates(QDateTime::currentDateTime().addDays(-3));
+    ConverterRunner staleRunner(this, QVariantList());
+    staleRunner.init();
+
+    Plasma::RunnerContext staleContext;
+    staleContext.setQuery(QStringLiteral("100 usd > eur"));
+    staleRunner.match(staleContext);
+    QCOMPARE(staleContext.matches().count(), 1);
+    QCOMPARE(staleContext.matches().first().text(), QStringLiteral("88.31 euros (EUR)"));
+    QVERIFY(!staleContext.matches().first().subtext().isEmpty());
+}
+
+/**
+ * Test if the table of unit aliases is answered from its cache, unless the languages changed
+ */
+void ConverterRunnerTest::testCompatibleUnitsCache()
+{
+    // written by the first query of the shared runner
+    QString key;
+    QMap<QString, QString> units;
+    readCompatibleUnits(&key, &units);
+    QVERIFY(units.contains(QStringLiteral("CENTIMETER")));
+
+    // an alias only the cache knows of proves it is loaded instead of rebuilt
+    units.insert(QStringLiteral("CACHEDUNIT"), QStringLiteral("cm"));
+    writeCompatibleUnits(key, units);
+
+    ConverterRunner cachedRunner(this, QVariantList());
+    cachedRunner.init();
+    Plasma::RunnerContext cachedContext;
+    cachedContext.setQuery(QStringLiteral("1 cachedunit > mm"));
+    cachedRunner.match(cachedContext);
+    QCOMPARE(cachedContext.matches().count(), 1);
+    QCOMPARE(cachedContext.matches().first().text(), QStringLiteral("10 millimeters (mm)"));
+
+    // other languages translate the unit names differently
+    QLocale::setDefault(QLocale::German);
+    ConverterRunner germanRunner(this, QVariantList());
+    germanRunner.init();
+    Plasma::RunnerContext germanContext;
+    germanContext.setQuery(QStringLiteral("1 cachedunit > mm"));
+    germanRunner.match(germanContext);
+    QLocale::setDefault(QLocale::English);
+    QCOMPARE(germanContext.matches().count(), 0);
+
+    QString germanKey;
+    QMap<QString, QString> germanUnits;
+    readCompatibleUnits(&germanKey, &germanUnits);
+    QVERIFY(germanKey != key);
+    QVERIFY(!germanUnits.contains(QStringLiteral("CACHEDUNIT")));
+
+    QFile::remove(compatibleUnitsPath());
+}
+
 QTEST_MAIN(ConverterRunnerTest)
 
 #include "converterrunnertest.moc"
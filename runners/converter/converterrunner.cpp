@@ -17,15 +17,35 @@
  */
 
 #include "converterrunner.h"
+#include "currencyrates.h"
 
 #include <QGuiApplication>
 #include <QClipboard>
+#include <QDataStream>
 #include <QDesktopServices>
 #include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
 #include <KLocalizedString>
+#include <kunitconversion_version.h>
 
+#include <algorithm>
 #include <cmath>
 
+namespace {
+const quint32 s_compatibleUnitsMagic = 0x4b435501; // "KCU" and the format version
+
+QString compatibleUnitsCachePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+        + QStringLiteral("/krunner_converter/compatibleunits");
+}
+}
+
 ConverterRunner::ConverterRunner(QObject *parent, const QVariantList &args)
     : Plasma::AbstractRunner(parent, args)
 {
@@ -54,7 +74,7 @@ void ConverterRunner::init()
     valueRegex.optimize();
     unitSeperatorRegex.optimize();
 
-    insertCompatibleUnits();
+    currencyRates = new CurrencyRates(this);
 
     addAction(copyActionId, QIcon::fromTheme(QStringLiteral("edit-copy")),
               QStringLiteral("Copy number"));
@@ -72,6 +92,10 @@ void ConverterRunner::match(Plasma::RunnerContext &context)
         return;
     }
 
+    std::call_once(compatibleUnitsLoaded, [this] {
+        insertCompatibleUnits();
+    });
+
     const QRegularExpressionMatch valueRegexMatch = valueRegex.match(context.query());
     if (!valueRegexMatch.hasMatch()) {
         return;
@@ -119,8 +143,18 @@ void ConverterRunner::match(Plasma::RunnerContext &context)
     const double numberValue = numberDataPair.second;
     QList<Plasma::QueryMatch> matches;
     for (const KUnitConversion::Unit &outputUnit: outputUnits) {
-        KUnitConversion::Value outputValue = inputCategory.convert(
-            KUnitConversion::Value(numberValue, inputUnit), outputUnit);
+        KUnitConversion::Value outputValue;
+        QDateTime ratesFetched;
+        if (inputCategory.id() == KUnitConversion::CurrencyCategory) {
+            // Answered from the last snapshot, KUnitConversion would download stale rates right here
+            double convertedValue;
+            if (!currencyRates->convert(numberValue, inputUnit.symbol(), outputUnit.symbol(), &convertedValue, &ratesFetched)) {
+                continue;
+            }
+            outputValue = KUnitConversion::Value(convertedValue, outputUnit);
+        } else {
+            outputValue = inputCategory.convert(KUnitConversion::Value(numberValue, inputUnit), outputUnit);
+        }
         if (!outputValue.isValid() || inputUnit == outputUnit) {
             continue;
         }
@@ -131,6 +165,10 @@ void ConverterRunner::match(Plasma::RunnerContext &context)
         if (outputUnit.categoryId() == KUnitConversion::CurrencyCategory) {
             outputValue.round(2);
             match.setText(QStringLiteral("%1 (%2)").arg(outputValue.toString(0, 'f', 2), outputUnit.symbol()));
+            if (CurrencyRates::isStale(ratesFetched)) {
+                match.setSubtext(i18nc("@info %1 is a date", "Exchange rate of %1, may be outdated",
+                                       locale.toString(ratesFetched.date(), QLocale::ShortFormat)));
+            }
         } else {
             match.setText(QStringLiteral("%1 (%2)").arg(outputValue.toString(), outputUnit.symbol()));
         }
@@ -202,6 +240,62 @@ QPair<bool, double> ConverterRunner::getValidatedNumberValue(const QString &valu
     }
 }
 
+/**
+ * Returns the units of all names and symbols starting with @p prefix, ranked by how much
+ * of the name is left to type. compatibleUnits is sorted, so they are found in O(log n)
+ * as one run of keys. Only if there is none, names starting with a slightly mistyped
+ * @p prefix are looked for.
+ */
+QVector<QPair<int, QString>> ConverterRunner::completeUnit(const QString &prefix) const
+{
+    QVector<QPair<int, QString>> completions;
+    for (auto it = compatibleUnits.lowerBound(prefix); it != compatibleUnits.constEnd() && it.key().startsWith(prefix); ++it) {
+        completions.append({it.key().size() - prefix.size(), it.value()});
+    }
+    if (!completions.isEmpty() || prefix.size() < 3) {
+        return completions;
+    }
+
+    for (auto it = compatibleUnits.constBegin(); it != compatibleUnits.constEnd(); ++it) {
+        const QString &key = it.key();
+        for (int length = prefix.size() - 1; length <= prefix.size() + 1; ++length) {
+            if (key.size() >= length && isSingleEdit(prefix, key.leftRef(length))) {
+                completions.append({key.size() - length + compatibleUnits.size(), it.value()});
+                break;
+            }
+        }
+    }
+    return completions;
+}
+
+/**
+ * Whether @p typed is @p name with one character substituted, added, dropped
+ * or two adjacent characters swapped
+ */
+bool ConverterRunner::isSingleEdit(const QString &typed, const QStringRef &name)
+{
+    const int sizeDifference = typed.size() - name.size();
+    if (sizeDifference < -1 || sizeDifference > 1) {
+        return false;
+    }
+
+    int i = 0;
+    while (i < typed.size() && i < name.size() && typed.at(i) == name.at(i)) {
+        ++i;
+    }
+    if (sizeDifference > 0) {
+        return typed.midRef(i + 1) == name.mid(i);
+    } else if (sizeDifference < 0) {
+        return typed.midRef(i) == name.mid(i + 1);
+    } else if (i == typed.size()) {
+        // identical, which a prefix search would have found
+        return false;
+    } else if (i + 1 < typed.size() && typed.at(i) == name.at(i + 1) && typed.at(i + 1) == name.at(i)) {
+        return typed.midRef(i + 2) == name.mid(i + 2);
+    }
+    return typed.midRef(i + 1) == name.mid(i + 1);
+}
+
 QList<KUnitConversion::Unit> ConverterRunner::createResultUnits(QString &outputUnitString,
                                                                 const KUnitConversion::UnitCategory &category)
 {
@@ -213,12 +307,18 @@ QList<KUnitConversion::Unit> ConverterRunner::createResultUnits(QString &outputU
         } else {
             // Autocompletion for the target units
             outputUnitString = outputUnitString.toUpper();
-            for (const auto &unitStringKey: compatibleUnits.keys()) {
-                if (unitStringKey.startsWith(outputUnitString)) {
-                    outputUnit = category.unit(compatibleUnits.value(unitStringKey));
-                    if (!units.contains(outputUnit)) {
-                        units << outputUnit;
-                    }
+            QVector<QPair<int, QString>> completions = completeUnit(outputUnitString);
+            // Names closest to what was typed first, mistyped ones after all others
+            std::stable_sort(completions.begin(), completions.end(),
+                             [](const QPair<int, QString> &a, const QPair<int, QString> &b) {
+                return a.first < b.first;
+            });
+            QSet<int> completedUnits;
+            for (const auto &completion: qAsConst(completions)) {
+                outputUnit = category.unit(completion.second);
+                if (outputUnit.isValid() && !completedUnits.contains(outputUnit.id())) {
+                    completedUnits.insert(outputUnit.id());
+                    units << outputUnit;
                 }
             }
         }
@@ -239,6 +339,14 @@ QList<KUnitConversion::Unit> ConverterRunner::createResultUnits(QString &outputU
 }
 void ConverterRunner::insertCompatibleUnits()
 {
+    // The table only depends on the units of KUnitConversion, their translations and the
+    // locale data of Qt, building it walks hundreds of locales and thousands of unit names
+    const QString cacheKey = QStringLiteral(KUNITCONVERSION_VERSION_STRING) + QLatin1Char('|')
+        + QString::fromLatin1(qVersion()) + QLatin1Char('|') + QLocale().uiLanguages().join(QLatin1Char(','));
+    if (loadCompatibleUnits(cacheKey)) {
+        return;
+    }
+
     // Add all currency symbols to the map, if their ISO code is supported by backend
     const QList<QLocale> allLocales = QLocale::matchingLocales(
         QLocale::AnyLanguage, QLocale::AnyScript, QLocale::AnyCountry);
@@ -264,4 +372,47 @@ void ConverterRunner::insertCompatibleUnits()
             compatibleUnits.insert(unit.toUpper(), unit);
         }
     }
+
+    saveCompatibleUnits(cacheKey);
+}
+
+bool ConverterRunner::loadCompatibleUnits(const QString &cacheKey)
+{
+    QFile file(compatibleUnitsCachePath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+    quint32 magic;
+    QString key;
+    stream >> magic >> key;
+    if (magic != s_compatibleUnitsMagic || key != cacheKey) {
+        return false;
+    }
+
+    QMap<QString, QString> units;
+    stream >> units;
+    if (stream.status() != QDataStream::Ok || units.isEmpty()) {
+        return false;
+    }
+
+    compatibleUnits = units;
+    return true;
+}
+
+void ConverterRunner::saveCompatibleUnits(const QString &cacheKey) const
+{
+    const QString path = compatibleUnitsCachePath();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+    stream << s_compatibleUnitsMagic << cacheKey << compatibleUnits;
+    file.commit();
 }
@@ -23,9 +23,14 @@
 #include <QRegularExpression>
 #include <QLocale>
 #include <QAction>
+#include <QVector>
 #include <KUnitConversion/Converter>
 #include <KUnitConversion/UnitCategory>
 
+#include <mutex>
+
+class CurrencyRates;
+
 
 /**
  * This class converts values to different units.
@@ -51,13 +56,20 @@ private:
     QRegularExpression unitSeperatorRegex;
     /** To convert currency symbols back to ISO string and handle case sensitive units */
     QMap<QString, QString> compatibleUnits;
+    /** compatibleUnits is filled on the first query, from the cache if possible */
+    std::once_flag compatibleUnitsLoaded;
+    CurrencyRates *currencyRates = nullptr;
 
     QList<QAction *> actionList;
     QLatin1String copyActionId = QLatin1String("copy");
     QLatin1String copyUnitActionId = QLatin1String("copy-unit");
 
+    bool loadCompatibleUnits(const QString &cacheKey);
+    void saveCompatibleUnits(const QString &cacheKey) const;
     QPair<bool, double> stringToDouble(const QStringRef &value);
     QPair<bool, double> getValidatedNumberValue(const QString &value);
+    QVector<QPair<int, QString>> completeUnit(const QString &prefix) const;
+    static bool isSingleEdit(const QString &typed, const QStringRef &name);
     QList<KUnitConversion::Unit> createResultUnits(QString &outputUnitString,
                                                    const KUnitConversion::UnitCategory &category);
 };
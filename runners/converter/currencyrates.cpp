@@ -0,0 +1,156 @@
+/*
+ * Copyright 2020 Alexander Lohnau <alexander.lohnau@gmx.de>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "currencyrates.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QUrl>
+#include <QXmlStreamReader>
+
+namespace {
+const QString s_ratesUrl = QStringLiteral("https://www.ecb.europa.eu/stats/eurofxref/eurofxref-daily.xml");
+// the bank publishes once every working day
+const int s_refreshAge = 6 * 60 * 60;
+const int s_staleAge = 24 * 60 * 60;
+const int s_refreshInterval = 60 * 60 * 1000;
+
+// Lets the autotests keep the refresh off the network
+QUrl ratesUrl()
+{
+    const QByteArray testUrl = qgetenv("KRUNNER_CONVERTER_RATES_URL");
+    return QUrl(testUrl.isEmpty() ? s_ratesUrl : QString::fromLocal8Bit(testUrl));
+}
+
+QString snapshotPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+        + QStringLiteral("/krunner_converter/currency.xml");
+}
+}
+
+CurrencyRates::CurrencyRates(QObject *parent)
+    : QObject(parent)
+    , m_network(new QNetworkAccessManager(this))
+    , m_refreshTimer(new QTimer(this))
+{
+    // The snapshot of an earlier run, or else the table KUnitConversion fetched last
+    for (const QString &path : {snapshotPath(),
+                                QStandardPaths::locate(QStandardPaths::GenericDataLocation,
+                                                       QStringLiteral("libkunitconversion/currency.xml"))}) {
+        QFile file(path);
+        if (!path.isEmpty() && file.open(QIODevice::ReadOnly) && load(file.readAll(), QFileInfo(file).lastModified())) {
+            break;
+        }
+    }
+
+    connect(m_network, &QNetworkAccessManager::finished, this, &CurrencyRates::downloadFinished);
+    connect(m_refreshTimer, &QTimer::timeout, this, &CurrencyRates::refresh);
+    m_refreshTimer->start(s_refreshInterval);
+    refresh();
+}
+
+CurrencyRates::~CurrencyRates() = default;
+
+bool CurrencyRates::convert(double value, const QString &from, const QString &to, double *result, QDateTime *fetched) const
+{
+    QReadLocker locker(&m_lock);
+    const auto fromRate = m_ratesPerEuro.constFind(from);
+    const auto toRate = m_ratesPerEuro.constFind(to);
+    if (fromRate == m_ratesPerEuro.constEnd() || toRate == m_ratesPerEuro.constEnd()) {
+        return false;
+    }
+
+    *result = value / *fromRate * *toRate;
+    *fetched = m_fetched;
+    return true;
+}
+
+bool CurrencyRates::isStale(const QDateTime &fetched)
+{
+    return !fetched.isValid() || fetched.secsTo(QDateTime::currentDateTime()) > s_staleAge;
+}
+
+void CurrencyRates::refresh()
+{
+    {
+        QReadLocker locker(&m_lock);
+        if (m_fetched.isValid() && m_fetched.secsTo(QDateTime::currentDateTime()) < s_refreshAge) {
+            return;
+        }
+    }
+
+    QNetworkRequest request{ratesUrl()};
+    request.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::NoLessSafeRedirectPolicy);
+    m_network->get(request);
+}
+
+bool CurrencyRates::load(const QByteArray &data, const QDateTime &fetched)
+{
+    // <Cube currency="USD" rate="1.1324"/>, all relative to the euro
+    QHash<QString, double> ratesPerEuro;
+    ratesPerEuro.insert(QStringLiteral("EUR"), 1.0);
+    QXmlStreamReader reader(data);
+    while (!reader.atEnd()) {
+        reader.readNext();
+        if (reader.isStartElement() && reader.name() == QLatin1String("Cube")) {
+            const QXmlStreamAttributes attributes = reader.attributes();
+            bool ok = false;
+            const double rate = attributes.value(QLatin1String("rate")).toDouble(&ok);
+            if (ok && rate > 0) {
+                ratesPerEuro.insert(attributes.value(QLatin1String("currency")).toString(), rate);
+            }
+        }
+    }
+    if (reader.hasError() || ratesPerEuro.size() < 2) {
+        return false;
+    }
+
+    QWriteLocker locker(&m_lock);
+    m_ratesPerEuro = ratesPerEuro;
+    m_fetched = fetched;
+    return true;
+}
+
+void CurrencyRates::downloadFinished(QNetworkReply *reply)
+{
+    reply->deleteLater();
+    if (reply->error() != QNetworkReply::NoError) {
+        // the snapshot stays in use, the next refresh tries again
+        return;
+    }
+
+    const QByteArray data = reply->readAll();
+    if (!load(data, QDateTime::currentDateTime())) {
+        return;
+    }
+
+    const QString path = snapshotPath();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(data);
+        file.commit();
+    }
+}
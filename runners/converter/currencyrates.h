@@ -0,0 +1,76 @@
+/*
+ * Copyright 2020 Alexander Lohnau <alexander.lohnau@gmx.de>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CURRENCYRATES_H
+#define CURRENCYRATES_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QObject>
+#include <QReadWriteLock>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+class QTimer;
+
+/**
+ * Exchange rates of the European Central Bank, refreshed in the background.
+ *
+ * KUnitConversion downloads the rates synchronously inside the converting thread
+ * whenever its copy is a day old. Instead, the last snapshot is kept on disk and
+ * answered from right away, while a new one is fetched every few hours.
+ */
+class CurrencyRates : public QObject
+{
+Q_OBJECT
+
+public:
+    explicit CurrencyRates(QObject *parent = nullptr);
+    ~CurrencyRates() override;
+
+    /**
+     * Converts @p value from the currency with ISO code @p from to @p to
+     * with the rates of the snapshot. May be called from any thread.
+     *
+     * @param fetched set to when the rates used were fetched
+     * @return false if the snapshot has no rate for either currency
+     */
+    bool convert(double value, const QString &from, const QString &to, double *result, QDateTime *fetched) const;
+
+    /**
+     * Whether rates fetched at @p fetched may have been superseded by now
+     */
+    static bool isStale(const QDateTime &fetched);
+
+    /**
+     * Fetches new rates unless the snapshot is recent enough
+     */
+    void refresh();
+
+private:
+    bool load(const QByteArray &data, const QDateTime &fetched);
+    void downloadFinished(QNetworkReply *reply);
+
+    mutable QReadWriteLock m_lock;
+    QHash<QString, double> m_ratesPerEuro;
+    QDateTime m_fetched;
+
+    QNetworkAccessManager *m_network = nullptr;
+    QTimer *m_refreshTimer = nullptr;
+};
+
+#endif
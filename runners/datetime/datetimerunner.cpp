@@ -19,11 +19,13 @@
  */
 
 #include "datetimerunner.h"
+#include "timezoneindex.h"
 
 #include <QLocale>
 #include <QIcon>
 #include <QTimeZone>
 
+#include <KDirWatch>
 #include <KLocalizedString>
 
 static const QString dateWord = i18nc("Note this is a KRunner keyword", "date");
@@ -38,6 +40,20 @@ DateTimeRunner::DateTimeRunner(QObject *parent, const QVariantList &args)
     addSyntax(Plasma::RunnerSyntax(dateWord + QLatin1String( " :q:" ), i18n("Displays the current date in a given timezone")));
     addSyntax(Plasma::RunnerSyntax(timeWord, i18n("Displays the current time")));
     addSyntax(Plasma::RunnerSyntax(timeWord + QLatin1String( " :q:" ), i18n("Displays the current time in a given timezone")));
+
+    // the index is rebuilt on the next query after the time zone database got updated, the
+    // zones live in subdirectories. Note that Qt caches the zone list and the rules of every
+    // zone it loaded for the whole process, so the rebuilt index only picks up what Qt
+    // hands out anew; changed rules of zones already in use need a restart of the process
+    QString zoneInfoDir = qEnvironmentVariable("TZDIR");
+    if (zoneInfoDir.isEmpty()) {
+        zoneInfoDir = QStringLiteral("/usr/share/zoneinfo");
+    }
+    m_zoneInfoWatch = new KDirWatch(this);
+    m_zoneInfoWatch->addDir(zoneInfoDir, KDirWatch::WatchSubDirs);
+    connect(m_zoneInfoWatch, &KDirWatch::dirty, this, &DateTimeRunner::resetTimeZoneIndex);
+    connect(m_zoneInfoWatch, &KDirWatch::created, this, &DateTimeRunner::resetTimeZoneIndex);
+    connect(m_zoneInfoWatch, &KDirWatch::deleted, this, &DateTimeRunner::resetTimeZoneIndex);
 }
 
 DateTimeRunner::~DateTimeRunner()
@@ -47,22 +63,23 @@ DateTimeRunner::~DateTimeRunner()
 void DateTimeRunner::match(Plasma::RunnerContext &context)
 {
     const QString term = context.query();
+    const QDateTime now = QDateTime::currentDateTime();
     if (term.compare(dateWord, Qt::CaseInsensitive) == 0) {
-        const QString date = QLocale().toString(QDate::currentDate());
+        const QString date = QLocale().toString(now.date());
         addMatch(i18n("Today's date is %1", date), date, context, QStringLiteral("view-calendar-day"));
     } else if (term.startsWith(dateWord + QLatin1Char( ' ' ), Qt::CaseInsensitive)) {
         const auto tz = term.rightRef(term.length() - dateWord.length() - 1);
-        const auto dates = datetime(tz);
+        const auto dates = datetime(tz, now);
         for(auto it = dates.constBegin(), itEnd = dates.constEnd(); it != itEnd; ++it) {
             const QString date = QLocale().toString(*it);
             addMatch(QStringLiteral("%1 - %2").arg(it.key(), date), date, context, QStringLiteral("view-calendar-day"));
         }
     } else if (term.compare(timeWord, Qt::CaseInsensitive) == 0) {
-        const QString time = QLocale().toString(QTime::currentTime());
+        const QString time = QLocale().toString(now.time());
         addMatch(i18n("Current time is %1", time), time, context, QStringLiteral("clock"));
     } else if (term.startsWith(timeWord + QLatin1Char( ' ' ), Qt::CaseInsensitive)) {
         const auto tz = term.rightRef(term.length() - timeWord.length() - 1);
-        const auto times = datetime(tz);
+        const auto times = datetime(tz, now);
         for(auto it = times.constBegin(), itEnd = times.constEnd(); it != itEnd; ++it) {
             const QString time = QLocale().toString(*it, QLocale::ShortFormat);
             addMatch(QStringLiteral("%1 - %2").arg(it.key(), time), time, context, QStringLiteral("clock"));
@@ -70,37 +87,32 @@ void DateTimeRunner::match(Plasma::RunnerContext &context)
     }
 }
 
-QHash<QString, QDateTime> DateTimeRunner::datetime(const QStringRef& tz)
+QSharedPointer<const TimeZoneIndex> DateTimeRunner::timeZoneIndex()
 {
-    QHash<QString, QDateTime> ret;
-    //
-    // KTimeZone gives us the actual timezone names such as "Asia/Kolkatta" and does
-    // not give us country info. QTimeZone does not give us the actual timezone name
-    // This is why we are using both for now.
-    //
-    const QList<QByteArray> timeZoneIds = QTimeZone::availableTimeZoneIds();
-    for (const QByteArray& zoneId : timeZoneIds) {
-        QTimeZone timeZone(zoneId);
-
-        const QString zoneName = QString::fromUtf8(zoneId);
-        if (zoneName.contains(tz, Qt::CaseInsensitive)) {
-            ret[zoneName] = QDateTime::currentDateTimeUtc().toTimeZone(timeZone);
-            continue;
-        }
+    QMutexLocker locker(&m_indexMutex);
+    if (!m_index) {
+        m_index.reset(new TimeZoneIndex);
+    }
+    return m_index;
+}
 
-        const QString country = QLocale::countryToString(timeZone.country());
-        if (country.contains(tz, Qt::CaseInsensitive)) {
-            ret[country] = QDateTime::currentDateTimeUtc().toTimeZone(timeZone);
-            continue;
-        }
+void DateTimeRunner::resetTimeZoneIndex()
+{
+    // queries still running keep their reference to the old index
+    QMutexLocker locker(&m_indexMutex);
+    m_index.reset();
+}
 
-        // FIXME: This only includes the current abbreviation and not old abbreviation or
-        // other possible names.
-        // Eg - depending on the current date, only CET or CEST will work
-        const QString abbr = timeZone.abbreviation(QDateTime::currentDateTime());
-        if (abbr.contains(tz, Qt::CaseInsensitive)) {
-            ret[abbr] = QDateTime::currentDateTimeUtc().toTimeZone(timeZone);
-            continue;
+QHash<QString, QDateTime> DateTimeRunner::datetime(const QStringRef &tz, const QDateTime &now)
+{
+    QHash<QString, QDateTime> ret;
+    const QDateTime nowUtc = now.toUTC();
+    const QVector<TimeZoneIndex::Match> matches = timeZoneIndex()->find(tz);
+    for (const TimeZoneIndex::Match &match : matches) {
+        // several zones share a country or an abbreviation, only the first one is shown:
+        // matches by prefix come first, then the zones in the order of their ids
+        if (!ret.contains(match.label)) {
+            ret.insert(match.label, nowUtc.toTimeZone(match.zone));
         }
     }
 
@@ -20,10 +20,15 @@
 #define DATETIMERUNNER_H
 
 #include <QDateTime>
+#include <QMutex>
+#include <QSharedPointer>
 
 #include <KRunner/AbstractRunner>
 #include <KRunner/QueryMatch>
 
+class KDirWatch;
+class TimeZoneIndex;
+
 /**
  * This class looks for matches in the set of .desktop files installed by
  * applications. This way the user can type exactly what they see in the
@@ -42,9 +47,15 @@ public:
     void match(Plasma::RunnerContext &context) override;
 
 private:
-    QHash<QString, QDateTime> datetime(const QStringRef &tz);
+    QSharedPointer<const TimeZoneIndex> timeZoneIndex();
+    void resetTimeZoneIndex();
+    QHash<QString, QDateTime> datetime(const QStringRef &tz, const QDateTime &now);
     void addMatch(const QString &text, const QString &clipboardText,
                   Plasma::RunnerContext &context, const QString& iconName);
+
+    QMutex m_indexMutex;
+    QSharedPointer<const TimeZoneIndex> m_index;
+    KDirWatch *m_zoneInfoWatch = nullptr;
 };
 
 #endif
@@ -0,0 +1,105 @@
+/*
+ *   Copyright 2020 Alexander Lohnau <alexander.lohnau@gmx.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License version 2 as
+ *   published by the Free Software Foundation
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "timezoneindex.h"
+
+#include <QDateTime>
+#include <QLocale>
+#include <QSet>
+
+#include <algorithm>
+
+TimeZoneIndex::TimeZoneIndex()
+{
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    const QDateTime historyStart(QDate(1970, 1, 1), QTime(0, 0), Qt::UTC);
+
+    const QList<QByteArray> timeZoneIds = QTimeZone::availableTimeZoneIds();
+    m_zones.reserve(timeZoneIds.size());
+    for (const QByteArray &zoneId : timeZoneIds) {
+        const QTimeZone timeZone(zoneId);
+        if (!timeZone.isValid()) {
+            continue;
+        }
+        const int zone = m_zones.size();
+        m_zones.append(timeZone);
+
+        const QString zoneName = QString::fromUtf8(zoneId);
+        add(zoneName, zone);
+        // "America/Argentina/Buenos_Aires" is found as "Buenos Aires" as well
+        const QString city = zoneName.section(QLatin1Char('/'), -1).replace(QLatin1Char('_'), QLatin1Char(' '));
+        if (city != zoneName) {
+            m_entries.append({city.toLower(), zoneName, zone});
+        }
+
+        if (timeZone.country() != QLocale::AnyCountry) {
+            add(QLocale::countryToString(timeZone.country()), zone);
+        }
+
+        QSet<QString> abbreviations;
+        abbreviations.insert(timeZone.abbreviation(now));
+        if (timeZone.hasTransitions()) {
+            const QTimeZone::OffsetDataList transitions = timeZone.transitions(historyStart, now.addYears(1));
+            for (const QTimeZone::OffsetData &transition : transitions) {
+                abbreviations.insert(transition.abbreviation);
+            }
+        }
+        for (const QString &abbreviation : qAsConst(abbreviations)) {
+            if (!abbreviation.isEmpty()) {
+                add(abbreviation, zone);
+            }
+        }
+    }
+
+    // zones sharing a name are kept in the order of their ids
+    std::sort(m_entries.begin(), m_entries.end(), [](const Entry &a, const Entry &b) {
+        return a.key < b.key || (a.key == b.key && a.zone < b.zone);
+    });
+}
+
+void TimeZoneIndex::add(const QString &label, int zone)
+{
+    m_entries.append({label.toLower(), label, zone});
+}
+
+QVector<TimeZoneIndex::Match> TimeZoneIndex::find(const QStringRef &term) const
+{
+    QVector<Match> matches;
+    const QString key = term.toString().toLower();
+    if (key.isEmpty()) {
+        return matches;
+    }
+
+    auto it = std::lower_bound(m_entries.cbegin(), m_entries.cend(), key, [](const Entry &entry, const QString &key) {
+        return entry.key < key;
+    });
+    for (; it != m_entries.cend() && it->key.startsWith(key); ++it) {
+        matches.append({it->label, m_zones.at(it->zone)});
+    }
+
+    // shorter fragments are part of far too many names to be of use
+    if (key.size() >= 3) {
+        for (const Entry &entry : m_entries) {
+            if (!entry.key.startsWith(key) && entry.key.contains(key)) {
+                matches.append({entry.label, m_zones.at(entry.zone)});
+            }
+        }
+    }
+
+    return matches;
+}
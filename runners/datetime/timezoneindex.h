@@ -0,0 +1,64 @@
+/*
+ *   Copyright 2020 Alexander Lohnau <alexander.lohnau@gmx.de>
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License version 2 as
+ *   published by the Free Software Foundation
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef TIMEZONEINDEX_H
+#define TIMEZONEINDEX_H
+
+#include <QString>
+#include <QTimeZone>
+#include <QVector>
+
+/**
+ * Searchable names of all time zones: the zone ids ("America/New_York"), their
+ * cities ("New York"), countries and every abbreviation they used since 1970
+ * or will use within a year, so both "CET" and "CEST" are found all year round.
+ *
+ * Constructing it walks the whole time zone database, looking names up is
+ * cheap and does not touch the database anymore. It is immutable once built,
+ * and so safe to share between threads.
+ */
+class TimeZoneIndex
+{
+public:
+    TimeZoneIndex();
+
+    struct Match {
+        QString label;
+        QTimeZone zone;
+    };
+
+    /**
+     * Returns the zones with a name starting with @p term, followed by those
+     * containing it if at least three characters were given. Case insensitive.
+     */
+    QVector<Match> find(const QStringRef &term) const;
+
+private:
+    struct Entry {
+        QString key;    // lower case, the index is sorted by it
+        QString label;
+        int zone;
+    };
+
+    void add(const QString &label, int zone);
+
+    QVector<Entry> m_entries;
+    QVector<QTimeZone> m_zones;
+};
+
+#endif
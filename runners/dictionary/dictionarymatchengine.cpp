@@ -3,15 +3,26 @@
  */
 
 #include "dictionarymatchengine.h"
+#include "dictionarycache.h"
 #include <KRunner/AbstractRunner>
 #include <QThread>
 #include <QMetaMethod>
 #include <QDebug>
-#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+#include <QTimer>
 #include <QDeadlineTimer>
-#endif
+
+#include <algorithm>
+
+// how long a runner thread waits for a definition before it gets delivered later on
+static const int s_lookupDeadline = 1500;
+// how often a waiting thread checks whether the query is still wanted
+static const int s_pollInterval = 100;
+// when a query the dictionary engine never answered is given up
+static const int s_lookupTimeout = 30 * 1000;
+
 DictionaryMatchEngine::DictionaryMatchEngine(Plasma::DataEngine *dictionaryEngine, QObject *parent)
     : QObject(parent),
+      m_sweepTimer(new QTimer(this)),
       m_dictionaryEngine(dictionaryEngine)
 {
     /* We have to connect source in two different places, due to the difference in
@@ -19,52 +30,82 @@ DictionaryMatchEngine::DictionaryMatchEngine(Plasma::DataEngine *dictionaryEngin
      * and this extra connection handles the second case. */
     Q_ASSERT(m_dictionaryEngine);
     connect(m_dictionaryEngine, SIGNAL(sourceAdded(QString)), this, SLOT(sourceAdded(QString)));
+
+    m_sweepTimer->setInterval(1000);
+    connect(m_sweepTimer, &QTimer::timeout, this, &DictionaryMatchEngine::sweepLookups);
 }
 
 /* This function should be called from a different thread. */
-QString DictionaryMatchEngine::lookupWord(const QString &word)
+void DictionaryMatchEngine::lookupWord(const QString &word, const Plasma::RunnerContext &context, const DefinitionCallback &callback)
 {
     if (!m_dictionaryEngine) {
         qDebug() << "Could not find dictionary data engine.";
-        return QString();
+        return;
     }
     if (thread() == QThread::currentThread()) {
         qDebug() << "DictionaryMatchEngine::lookupWord is only meant to be called from non-primary threads.";
-        return QString();
+        return;
     }
 
-    ThreadData data;
-
-    m_wordLock.lockForWrite();
-    m_lockers.insert(word, &data);
-    m_wordLock.unlock();
-
-    QMetaObject::invokeMethod(this, "sourceAdded", Qt::QueuedConnection, Q_ARG(const QString&, word));
-    QMutexLocker locker(&data.mutex);
-#if QT_VERSION < QT_VERSION_CHECK(5, 15, 0)
-    if (!data.waitCondition.wait(&data.mutex, 30 * 1000)) // Timeout after 30 seconds
-#else
-    if (!data.waitCondition.wait(&data.mutex, QDeadlineTimer(30 * 1000))) // Timeout after 30 seconds
-#endif
-        qDebug() << "The dictionary data engine timed out (word:" << word << ")";
-    locker.unlock();
+    QString dictionary;
+    QString cachedWord;
+    QString cachedDefinition;
+    DictionaryCache::splitSource(word, &dictionary, &cachedWord);
+    if (DictionaryCache::lookup(dictionary, cachedWord, &cachedDefinition)) {
+        Plasma::RunnerContext resultContext(context);
+        callback(resultContext, cachedDefinition);
+        return;
+    }
 
-    QMetaObject::invokeMethod(this, "sourceRemoved", Qt::QueuedConnection, Q_ARG(const QString&, word));
-    // after a timeout, if dataUpdated gets m_wordLock here, it can lock data->mutex successfully.
+    m_lookupsLock.lock();
+    QSharedPointer<Lookup> lookup = m_lookups.value(word);
+    const bool newLookup = !lookup;
+    if (newLookup) {
+        lookup.reset(new Lookup);
+        lookup->age.start();
+        m_lookups.insert(word, lookup);
+    }
+    // register as waiting before sweepLookups can see the lookup unused
+    QMutexLocker locker(&lookup->mutex);
+    ++lookup->waiting;
+    m_lookupsLock.unlock();
 
-    m_wordLock.lockForWrite();
-    m_lockers.remove(word, &data);
-    m_wordLock.unlock();
+    if (newLookup) {
+        QMetaObject::invokeMethod(this, "sourceAdded", Qt::QueuedConnection, Q_ARG(const QString&, word));
+    }
 
-    // after a timeout, if dataUpdated gets m_wordLock here, it won't see this data instance anymore.
+    const QDeadlineTimer deadline(s_lookupDeadline);
+    while (!lookup->done && context.isValid() && !deadline.hasExpired()) {
+        lookup->finished.wait(&lookup->mutex, QDeadlineTimer(qMin<qint64>(s_pollInterval, deadline.remainingTime())));
+    }
+    --lookup->waiting;
 
-    locker.relock();
-    return data.definition;
+    if (lookup->done) {
+        const QString definition = lookup->definition;
+        locker.unlock();
+        Plasma::RunnerContext resultContext(context);
+        callback(resultContext, definition);
+    } else if (context.isValid()) {
+        // don't keep the runner thread, the definition is handed over once it arrives
+        lookup->pending.append({context, callback});
+    }
+    // lookups nobody waits for anymore are dropped by sweepLookups
 }
 
 void DictionaryMatchEngine::sourceAdded(const QString &source)
 {
+    {
+        // swept already when the caller gave up before this queued call came through,
+        // dataUpdated() would then leave the source connected for good
+        QMutexLocker locker(&m_lookupsLock);
+        if (!m_lookups.contains(source)) {
+            return;
+        }
+    }
     m_dictionaryEngine->connectSource(source, this);
+    if (!m_sweepTimer->isActive()) {
+        m_sweepTimer->start();
+    }
 }
 
 void DictionaryMatchEngine::sourceRemoved(const QString &source)
@@ -72,21 +113,66 @@ void DictionaryMatchEngine::sourceRemoved(const QString &source)
     m_dictionaryEngine->disconnectSource(source, this);
 }
 
+void DictionaryMatchEngine::sweepLookups()
+{
+    QMutexLocker lookupsLocker(&m_lookupsLock);
+    for (auto it = m_lookups.begin(); it != m_lookups.end();) {
+        Lookup *lookup = it->data();
+        QMutexLocker locker(&lookup->mutex);
+        lookup->pending.erase(std::remove_if(lookup->pending.begin(), lookup->pending.end(), [](const PendingLookup &pending) {
+            return !pending.context.isValid();
+        }), lookup->pending.end());
+
+        const bool timedOut = lookup->age.hasExpired(s_lookupTimeout);
+        if (timedOut) {
+            qDebug() << "The dictionary data engine timed out (word:" << it.key() << ")";
+        }
+        if (timedOut || (lookup->waiting == 0 && lookup->pending.isEmpty())) {
+            // the query is cancelled, blocked callers see it as not done and give up
+            locker.unlock();
+            sourceRemoved(it.key());
+            it = m_lookups.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (m_lookups.isEmpty()) {
+        m_sweepTimer->stop();
+    }
+}
+
 void DictionaryMatchEngine::dataUpdated(const QString &source, const Plasma::DataEngine::Data &result)
 {
     if (!result.contains(QLatin1String("text")))
         return;
 
-    QString definition(result[QLatin1String("text")].toString());
+    m_lookupsLock.lock();
+    const QSharedPointer<Lookup> lookup = m_lookups.take(source);
+    m_lookupsLock.unlock();
+    if (!lookup)
+        return;
+    sourceRemoved(source);
 
-    m_wordLock.lockForRead();
-    foreach (ThreadData *data, m_lockers.values(source)) {
-        QMutexLocker locker(&data->mutex);
-        /* Because of QString's CoW semantics, we don't have to worry about
-         * the overhead of assigning this to every item. */
-        data->definition = definition;
-        data->waitCondition.wakeOne();
+    const QString definition(result[QLatin1String("text")].toString());
+    QString dictionary;
+    QString word;
+    DictionaryCache::splitSource(source, &dictionary, &word);
+    // nothing found, or the server could not be reached, may change later on
+    if (!definition.isEmpty()) {
+        DictionaryCache::insert(dictionary, word, definition);
     }
-    m_wordLock.unlock();
-}
 
+    QMutexLocker locker(&lookup->mutex);
+    lookup->done = true;
+    lookup->definition = definition;
+    const QVector<PendingLookup> pending = lookup->pending;
+    lookup->pending.clear();
+    lookup->finished.wakeAll();
+    locker.unlock();
+
+    for (PendingLookup pendingLookup : pending) {
+        if (pendingLookup.context.isValid()) {
+            pendingLookup.callback(pendingLookup.context, definition);
+        }
+    }
+}
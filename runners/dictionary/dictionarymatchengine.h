@@ -6,37 +6,61 @@
 #define DICTIONARYMATCHENGINE_H
 
 #include <Plasma/DataEngine>
+#include <KRunner/RunnerContext>
+#include <QElapsedTimer>
 #include <QHash>
-#include <QReadWriteLock>
 #include <QMutex>
-#include <QMultiMap>
+#include <QSharedPointer>
 #include <QWaitCondition>
 
-namespace Plasma
-{
-}
+#include <functional>
+
+class QTimer;
+
 class DictionaryMatchEngine : public QObject
 {
     Q_OBJECT
 
 public:
+    using DefinitionCallback = std::function<void(Plasma::RunnerContext &context, const QString &definition)>;
+
     explicit DictionaryMatchEngine(Plasma::DataEngine *dictionaryEngine, QObject *parent = nullptr);
-    QString lookupWord(const QString &word);
+
+    /**
+     * Looks up @p word and passes its definition to @p callback, unless @p context
+     * becomes invalid before. All lookups of the same word share one query.
+     *
+     * Waits for a short while only: if the definition is known by then, the callback
+     * runs in the calling thread before returning, otherwise later on in the thread of
+     * the engine.
+     */
+    void lookupWord(const QString &word, const Plasma::RunnerContext &context, const DefinitionCallback &callback);
 
 private:
-    struct ThreadData {
-        QWaitCondition waitCondition;
+    struct PendingLookup {
+        Plasma::RunnerContext context;
+        DefinitionCallback callback;
+    };
+    struct Lookup {
         QMutex mutex;
+        QWaitCondition finished;
+        bool done = false;
         QString definition;
+        int waiting = 0;                    // callers blocked in lookupWord
+        QVector<PendingLookup> pending;     // callers which stopped waiting but still want the definition
+        QElapsedTimer age;
     };
-    QMultiMap <QString, ThreadData*> m_lockers;
-    QReadWriteLock m_wordLock;
+
+    QHash<QString, QSharedPointer<Lookup>> m_lookups;
+    QMutex m_lookupsLock;
+    QTimer *m_sweepTimer;
     Plasma::DataEngine *m_dictionaryEngine;
 
 private Q_SLOTS:
     void dataUpdated(const QString &name, const Plasma::DataEngine::Data &data);
     void sourceAdded(const QString &source);
     void sourceRemoved(const QString &source);
+    void sweepLookups();
 
 };
 
@@ -44,8 +44,13 @@ void DictionaryRunner::match(Plasma::RunnerContext &context)
     query.remove(0, m_triggerWord.length());
     if (query.isEmpty())
         return;
-    QString returnedQuery = m_engine->lookupWord(query);
+    m_engine->lookupWord(query, context, [this, query](Plasma::RunnerContext &resultContext, const QString &definition) {
+        addDefinitionMatches(resultContext, query, definition);
+    });
+}
 
+void DictionaryRunner::addDefinitionMatches(Plasma::RunnerContext &context, const QString &query, const QString &returnedQuery)
+{
     if (!context.isValid())
         return;
 
@@ -65,7 +70,8 @@ void DictionaryRunner::match(Plasma::RunnerContext &context)
 
     QList<Plasma::QueryMatch> matches;
     int item = 0;
-    static const QRegExp partOfSpeech(QLatin1String("(?: ([a-z]{1,5})){0,1} [0-9]{1,2}: (.*)"));
+    // QRegExp keeps its captures, every caller needs its own
+    QRegExp partOfSpeech(QLatin1String("(?: ([a-z]{1,5})){0,1} [0-9]{1,2}: (.*)"));
     QString lastPartOfSpeech;
     foreach (const QString &line, lines) {
         if (partOfSpeech.indexIn(line) == -1)
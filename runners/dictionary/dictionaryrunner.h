@@ -18,6 +18,8 @@ public:
     void reloadConfiguration() override;
 
 private:
+    void addDefinitionMatches(Plasma::RunnerContext &context, const QString &query, const QString &definition);
+
     QString m_triggerWord;
     DictionaryMatchEngine *m_engine;
 
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2020 Alexander Lohnau <alexander.lohnau@gmx.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QTest>
+
+#include "fuzzymatcher.h"
+
+class FuzzyMatcherTest : public QObject
+{
+Q_OBJECT
+private Q_SLOTS:
+    void testRanking();
+    void testSubsequence();
+    void testCaseInsensitive();
+    void testEmptyTerm();
+    void testNoMatch();
+};
+
+static QStringList matchedNames(const FuzzyMatcher &matcher, const QStringList &items, const QString &term)
+{
+    QStringList names;
+    const auto matches = matcher.match(term);
+    for (const FuzzyMatcher::Match &match : matches) {
+        names.append(items.at(match.index));
+    }
+    return names;
+}
+
+void FuzzyMatcherTest::testRanking()
+{
+    const QStringList items{QStringLiteral("Work on kdevelop"), QStringLiteral("dev"),
+                            QStringLiteral("devel"), QStringLiteral("kdev-notes"), QStringLiteral("deliver")};
+    const FuzzyMatcher matcher(items);
+
+    const QStringList expected{QStringLiteral("dev"), QStringLiteral("devel"), QStringLiteral("kdev-notes"),
+                               QStringLiteral("Work on kdevelop"), QStringLiteral("deliver")};
+    QCOMPARE(matchedNames(matcher, items, QStringLiteral("dev")), expected);
+    QCOMPARE(matcher.match(QStringLiteral("dev")).constFirst().score, 1.0);
+}
+
+void FuzzyMatcherTest::testSubsequence()
+{
+    const QStringList items{QStringLiteral("Kate Session Work"), QStringLiteral("kiosk saw"), QStringLiteral("Music")};
+    const FuzzyMatcher matcher(items);
+
+    // word starts beat scattered characters
+    const QStringList expected{QStringLiteral("Kate Session Work"), QStringLiteral("kiosk saw")};
+    QCOMPARE(matchedNames(matcher, items, QStringLiteral("ksw")), expected);
+
+    const QStringList camelCase{QStringLiteral("MyRemoteHost")};
+    QCOMPARE(FuzzyMatcher(camelCase).match(QStringLiteral("mrh")).size(), 1);
+}
+
+void FuzzyMatcherTest::testCaseInsensitive()
+{
+    const FuzzyMatcher matcher({QStringLiteral("Straße")});
+    QCOMPARE(matcher.match(QStringLiteral("STRASSE")).size(), 1);
+    QCOMPARE(matcher.match(QStringLiteral("straße")).constFirst().score, 1.0);
+}
+
+void FuzzyMatcherTest::testEmptyTerm()
+{
+    const FuzzyMatcher matcher({QStringLiteral("b"), QStringLiteral("a")});
+    const auto matches = matcher.match(QString());
+    QCOMPARE(matches.size(), 2);
+    QCOMPARE(matches.at(0).index, 0);
+    QCOMPARE(matches.at(1).index, 1);
+}
+
+void FuzzyMatcherTest::testNoMatch()
+{
+    const FuzzyMatcher matcher({QStringLiteral("konsole"), QStringLiteral("kate")});
+    QVERIFY(matcher.match(QStringLiteral("xyz")).isEmpty());
+    QVERIFY(matcher.match(QStringLiteral("etak")).isEmpty());
+    QVERIFY(matcher.match(QStringLiteral("konsole profile")).isEmpty());
+}
+
+QTEST_GUILESS_MAIN(FuzzyMatcherTest)
+
+#include "fuzzymatchertest.moc"
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2020 Alexander Lohnau <alexander.lohnau@gmx.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "fuzzymatcher.h"
+
+#include <algorithm>
+
+FuzzyMatcher::FuzzyMatcher(const QStringList &items)
+{
+    setItems(items);
+}
+
+void FuzzyMatcher::setItems(const QStringList &items)
+{
+    m_items.clear();
+    m_items.reserve(items.size());
+    for (const QString &name : items) {
+        Item item;
+        item.folded = name.toCaseFolded();
+        // folding keeps the length of almost all names, the rare ones where it
+        // does not only lose their word start bonus
+        item.wordStarts.resize(item.folded.size());
+        if (item.folded.size() == name.size()) {
+            for (int i = 0; i < name.size(); ++i) {
+                const QChar c = name.at(i);
+                const QChar previous = i > 0 ? name.at(i - 1) : QChar();
+                item.wordStarts[i] = c.isLetterOrNumber()
+                                     && (i == 0 || !previous.isLetterOrNumber()
+                                         || (c.isUpper() && previous.isLower()));
+            }
+        } else if (!item.wordStarts.isEmpty()) {
+            item.wordStarts[0] = true;
+        }
+        item.characters = characterMask(item.folded);
+        m_items.append(item);
+    }
+}
+
+int FuzzyMatcher::size() const
+{
+    return m_items.size();
+}
+
+quint64 FuzzyMatcher::characterMask(const QString &folded)
+{
+    quint64 mask = 0;
+    for (const QChar c : folded) {
+        mask |= quint64(1) << (c.unicode() % 64);
+    }
+    return mask;
+}
+
+QVector<FuzzyMatcher::Match> FuzzyMatcher::match(const QString &term) const
+{
+    QVector<Match> matches;
+    const QString folded = term.toCaseFolded();
+    if (folded.isEmpty()) {
+        matches.reserve(m_items.size());
+        for (int i = 0; i < m_items.size(); ++i) {
+            matches.append({i, 1.0});
+        }
+        return matches;
+    }
+
+    const quint64 characters = characterMask(folded);
+    for (int i = 0; i < m_items.size(); ++i) {
+        const Item &item = m_items.at(i);
+        if ((item.characters & characters) != characters || item.folded.size() < folded.size()) {
+            continue;
+        }
+        const qreal itemScore = score(item, folded);
+        if (itemScore > 0) {
+            matches.append({i, itemScore});
+        }
+    }
+
+    std::stable_sort(matches.begin(), matches.end(), [](const Match &a, const Match &b) {
+        return a.score > b.score;
+    });
+    return matches;
+}
+
+qreal FuzzyMatcher::score(const Item &item, const QString &term)
+{
+    const QString &name = item.folded;
+    // how much of the name was typed, so that shorter names rank first within a tier
+    const qreal coverage = qreal(term.size()) / name.size();
+
+    if (name == term) {
+        return 1.0;
+    }
+    if (name.startsWith(term)) {
+        return 0.8 + 0.19 * coverage;
+    }
+    const int position = name.indexOf(term);
+    if (position > 0) {
+        return (item.wordStarts.at(position) ? 0.7 : 0.6) + 0.09 * coverage;
+    }
+
+    // every character is worth a point, starting a word or following the previously
+    // matched one earns more; the earliest occurrences are taken, which is good enough
+    // for the short names runners deal with
+    int points = 0;
+    int previous = -2;
+    int from = 0;
+    for (const QChar c : term) {
+        const int found = name.indexOf(c, from);
+        if (found < 0) {
+            return 0;
+        }
+        points += 1;
+        if (item.wordStarts.at(found)) {
+            points += 2;
+        } else if (found == previous + 1) {
+            points += 1;
+        }
+        previous = found;
+        from = found + 1;
+    }
+    return 0.2 + 0.39 * points / (3 * term.size()) * (0.5 + 0.5 * coverage);
+}
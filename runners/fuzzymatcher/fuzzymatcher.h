@@ -0,0 +1,76 @@
+/*
+ * Copyright 2020 Alexander Lohnau <alexander.lohnau@gmx.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FUZZYMATCHER_H
+#define FUZZYMATCHER_H
+
+#include <QStringList>
+#include <QVector>
+
+/**
+ * Matches a query against a fixed list of names, like the sessions or profiles
+ * offered by a runner, ranking them by how well the query fits.
+ *
+ * The query matches a name if its characters appear in the name in the same
+ * order, ignoring case: "ksw" matches "Kate Session Work". Exact names score
+ * highest, followed by names starting with the query, names containing it and
+ * finally names merely containing its characters, which score better the more
+ * of them start words or follow each other.
+ *
+ * Case folding and finding the word starts happens once in setItems(), so
+ * matching stays cheap for long lists. A matcher is not changed by match()
+ * and can be used from several threads once set up.
+ */
+class FuzzyMatcher
+{
+public:
+    struct Match {
+        int index;      // position of the name in the list given to setItems()
+        qreal score;    // in (0, 1], 1 only for an exact match
+    };
+
+    FuzzyMatcher() = default;
+    explicit FuzzyMatcher(const QStringList &items);
+
+    void setItems(const QStringList &items);
+    int size() const;
+
+    /**
+     * Returns the names matching @p term, best first. An empty term matches
+     * every name with the same score, in the order they were given.
+     */
+    QVector<Match> match(const QString &term) const;
+
+private:
+    struct Item {
+        QString folded;
+        QVector<bool> wordStarts;
+        quint64 characters;     // which characters occur, to skip names quickly
+    };
+
+    static quint64 characterMask(const QString &folded);
+    static qreal score(const Item &item, const QString &term);
+
+    QVector<Item> m_items;
+};
+
+Q_DECLARE_TYPEINFO(FuzzyMatcher::Match, Q_PRIMITIVE_TYPE);
+
+#endif
@@ -72,13 +72,25 @@ void KateSessions::loadSessions()
         sessions.append(QUrl::fromPercentEncoding(sessionFile.baseName().toLocal8Bit()));
     }
 
-    m_sessions = sessions;
+    QSharedPointer<Sessions> loaded(new Sessions);
+    loaded->names = sessions;
+    loaded->matcher.setItems(sessions);
+
+    QMutexLocker locker(&m_sessionsMutex);
+    m_sessions = loaded;
+}
+
+QSharedPointer<const KateSessions::Sessions> KateSessions::sessions()
+{
+    QMutexLocker locker(&m_sessionsMutex);
+    return m_sessions;
 }
 
 void KateSessions::match(Plasma::RunnerContext &context)
 {
     QString term = context.query();
-    if (term.length() < 3 || m_sessions.isEmpty() || !context.isValid()) {
+    const QSharedPointer<const Sessions> sessions = this->sessions();
+    if (term.length() < 3 || sessions->names.isEmpty() || !context.isValid()) {
         return;
     }
     // Kate writes sessions as desktop actions in the local .desktop file =>
@@ -98,17 +110,17 @@ void KateSessions::match(Plasma::RunnerContext &context)
         return;
     }
 
-    for (const QString &session: qAsConst(m_sessions)) {
-        if (listAll || session.contains(term, Qt::CaseInsensitive)) {
-            Plasma::QueryMatch match(this);
-            match.setType(Plasma::QueryMatch::ExactMatch);
-            match.setRelevance(session.compare(term, Qt::CaseInsensitive) == 0 ? 1 : 0.8);
-            match.setIconName(m_triggerWord);
-            match.setData(session);
-            match.setText(session);
-            match.setSubtext(i18n("Open Kate Session"));
-            context.addMatch(match);
-        }
+    const auto sessionMatches = sessions->matcher.match(term);
+    for (const FuzzyMatcher::Match &sessionMatch : sessionMatches) {
+        const QString &session = sessions->names.at(sessionMatch.index);
+        Plasma::QueryMatch match(this);
+        match.setType(Plasma::QueryMatch::ExactMatch);
+        match.setRelevance(listAll ? 0.8 : sessionMatch.score);
+        match.setIconName(m_triggerWord);
+        match.setData(session);
+        match.setText(session);
+        match.setSubtext(i18n("Open Kate Session"));
+        context.addMatch(match);
     }
 }
 
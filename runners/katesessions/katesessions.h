@@ -22,8 +22,13 @@
 #ifndef KATESESSIONS_H
 #define KATESESSIONS_H
 
+#include <QMutex>
+#include <QSharedPointer>
+
 #include <KRunner/AbstractRunner>
 
+#include "fuzzymatcher.h"
+
 class KDirWatch;
 
 class KateSessions : public Plasma::AbstractRunner {
@@ -40,9 +45,17 @@ class KateSessions : public Plasma::AbstractRunner {
         void loadSessions();
 
     private:
+        // replaced as a whole when the sessions change, queries keep the one they started with
+        struct Sessions {
+            QStringList names;
+            FuzzyMatcher matcher;
+        };
+        QSharedPointer<const Sessions> sessions();
+
         KDirWatch* m_sessionWatch = nullptr;
         QString m_sessionsFolderPath;
-        QStringList m_sessions;
+        QMutex m_sessionsMutex;
+        QSharedPointer<const Sessions> m_sessions;
         const QLatin1String m_triggerWord = QLatin1String("kate");
 };
 
@@ -23,14 +23,8 @@
 
 // KF
 #include <KIO/CommandLauncherJob>
-#include <KConfig>
-#include <KDirWatch>
 #include <KLocalizedString>
 #include <KNotificationJobUiDelegate>
-// Qt
-#include <QFileInfo>
-#include <QDir>
-#include <QStandardPaths>
 
 
 KonsoleProfiles::KonsoleProfiles(QObject *parent, const QVariantList &args)
@@ -54,49 +48,37 @@ KonsoleProfiles::~KonsoleProfiles() = default;
 void KonsoleProfiles::init()
 {
     // Initialize profiles and file watcher
-    m_profileFilesWatch = new KDirWatch(this);
-    const QStringList konsoleDataBaseDirs = QStandardPaths::standardLocations(QStandardPaths::GenericDataLocation);
-    for (const QString &konsoleDataBaseDir : konsoleDataBaseDirs) {
-        m_profileFilesWatch->addDir(konsoleDataBaseDir + QStringLiteral("/konsole"));
-    }
-
-    connect(m_profileFilesWatch, &KDirWatch::dirty, this, &KonsoleProfiles::loadProfiles);
-    connect(m_profileFilesWatch, &KDirWatch::created, this, &KonsoleProfiles::loadProfiles);
-    connect(m_profileFilesWatch, &KDirWatch::deleted, this, &KonsoleProfiles::loadProfiles);
-
+    m_profileIndex = new KonsoleProfileIndex(this);
+    m_profileIndex->update();
     loadProfiles();
+
+    connect(m_profileIndex, &KonsoleProfileIndex::profilesChanged, this, &KonsoleProfiles::loadProfiles);
 }
 
 void KonsoleProfiles::loadProfiles()
 {
-    m_profiles.clear();
+    QSharedPointer<Profiles> loaded(new Profiles);
+    loaded->profiles = m_profileIndex->profiles();
 
-    QStringList profilesPaths;
-    const QStringList dirs = QStandardPaths::locateAll(QStandardPaths::GenericDataLocation,
-                                                       QStringLiteral("konsole"), QStandardPaths::LocateDirectory);
-
-    for (const auto &dir : dirs) {
-        const QStringList fileNames = QDir(dir).entryList({QStringLiteral("*.profile")});
-        for (const QString &fileName : fileNames) {
-            profilesPaths.append(dir + QLatin1Char('/') + fileName);
-        }
+    QStringList displayNames;
+    displayNames.reserve(loaded->profiles.size());
+    for (const KonsoleProfile &profile : qAsConst(loaded->profiles)) {
+        displayNames.append(profile.displayName);
     }
+    loaded->matcher.setItems(displayNames);
 
-    for (const auto &profilePath : qAsConst(profilesPaths)) {
-        const QString profileName = QFileInfo(profilePath).baseName();
-
-        const KConfig _config(profilePath, KConfig::SimpleConfig);
-        if (_config.hasGroup("General")) {
-            KonsoleProfileData profileData;
-            const KConfigGroup cfg = _config.group("General");
-            profileData.displayName = cfg.readEntry("Name", profileName);
-            profileData.iconName = cfg.readEntry("Icon", QStringLiteral("utilities-terminal"));
-            if (!profileData.displayName.isEmpty()) {
-                m_profiles.append(profileData);
-            }
-        }
+    {
+        QMutexLocker locker(&m_profilesMutex);
+        m_profiles = loaded;
     }
-    suspendMatching(m_profiles.isEmpty());
+
+    suspendMatching(loaded->profiles.isEmpty());
+}
+
+QSharedPointer<const KonsoleProfiles::Profiles> KonsoleProfiles::profiles()
+{
+    QMutexLocker locker(&m_profilesMutex);
+    return m_profiles;
 }
 
 void KonsoleProfiles::match(Plasma::RunnerContext &context)
@@ -106,17 +88,26 @@ void KonsoleProfiles::match(Plasma::RunnerContext &context)
         return;
     }
 
+    // without the trigger word any query reaches us, only accept names containing it then
+    const bool triggered = term.contains(m_triggerWord);
     term = term.remove(m_triggerWord).simplified();
-    for (const KonsoleProfileData &data: qAsConst(m_profiles)) {
-        if (data.displayName.contains(term, Qt::CaseInsensitive)) {
-            Plasma::QueryMatch match(this);
-            match.setType(Plasma::QueryMatch::PossibleMatch);
-            match.setIconName(data.iconName);
-            match.setData(data.displayName);
-            match.setText(QStringLiteral("Konsole: ") + data.displayName);
-            match.setRelevance((float) term.length() / (float) data.displayName.length());
-            context.addMatch(match);
+    const QSharedPointer<const Profiles> profiles = this->profiles();
+    if (!profiles) {
+        return;
+    }
+    const auto profileMatches = profiles->matcher.match(term);
+    for (const FuzzyMatcher::Match &profileMatch : profileMatches) {
+        if (!triggered && profileMatch.score < 0.6) {
+            break;
         }
+        const KonsoleProfile &profile = profiles->profiles.at(profileMatch.index);
+        Plasma::QueryMatch match(this);
+        match.setType(Plasma::QueryMatch::PossibleMatch);
+        match.setIconName(profile.iconName);
+        match.setData(profile.name);
+        match.setText(QStringLiteral("Konsole: ") + profile.displayName);
+        match.setRelevance(term.isEmpty() ? 0.5 : profileMatch.score);
+        context.addMatch(match);
     }
 }
 void KonsoleProfiles::run(const Plasma::RunnerContext &context, const Plasma::QueryMatch &match)
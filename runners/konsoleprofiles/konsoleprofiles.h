@@ -21,17 +21,13 @@
 #ifndef KONSOLEPROFILES_H
 #define KONSOLEPROFILES_H
 
-#include <KRunner/AbstractRunner>
-
-class KDirWatch;
+#include <QMutex>
+#include <QSharedPointer>
 
-struct KonsoleProfileData
-{
-    QString displayName;
-    QString iconName;
-};
+#include <KRunner/AbstractRunner>
 
-Q_DECLARE_TYPEINFO(KonsoleProfileData, Q_MOVABLE_TYPE);
+#include "fuzzymatcher.h"
+#include "konsoleprofileindex.h"
 
 class KonsoleProfiles: public Plasma::AbstractRunner
 {
@@ -49,8 +45,16 @@ private Q_SLOTS:
     void loadProfiles();
 
 private:
-    KDirWatch *m_profileFilesWatch = nullptr;
-    QList<KonsoleProfileData> m_profiles;
+    // replaced as a whole when the profiles change, queries keep the one they started with
+    struct Profiles {
+        QVector<KonsoleProfile> profiles;
+        FuzzyMatcher matcher;
+    };
+    QSharedPointer<const Profiles> profiles();
+
+    KonsoleProfileIndex *m_profileIndex = nullptr;
+    QMutex m_profilesMutex;
+    QSharedPointer<const Profiles> m_profiles;
     QLatin1String m_triggerWord = QLatin1String("konsole");
 };
 
@@ -20,35 +20,81 @@
 
 #include "mediawiki.h"
 
-// KF
-#include <KRunner/RunnerContext>
 // Qt
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDeadlineTimer>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
 #include <QNetworkAccessManager>
 #include <QNetworkRequest>
 #include <QNetworkReply>
+#include <QSaveFile>
+#include <QStandardPaths>
 #include <QXmlStreamReader>
 #include <QTimer>
 #include <QUrlQuery>
 
+#include <algorithm>
+
 enum State {
     StateApiChanged,
     StateApiUpdating,
     StateReady
 };
 
+// how long what a wiki told about itself is trusted
+static const int s_siteInfoMaxAgeDays = 7;
+static const quint32 s_siteInfoMagic = 0x4d575331; // "MWS1"
+
 struct MediaWikiPrivate {
     int state;
-    QList<MediaWiki::Result> results;
     QUrl apiUrl;
     QUrl baseUrl;
     QNetworkAccessManager *manager;
-    int maxItems;
-    QNetworkReply *reply;
     int timeout;
-    QUrl query;
     QByteArray userAgent;
+    // searches with results lacking a URL, until the base URL is known
+    QHash<QSharedPointer<MediaWiki::Search>, QList<MediaWiki::Result>> waitingSearches;
+    QHash<MediaWiki::Search *, QNetworkReply *> searchReplies;
 };
 
+bool MediaWiki::Search::waitForFinished( int millis )
+{
+    QMutexLocker locker(&mutex);
+    const QDeadlineTimer deadline(millis);
+    while ( !done && !deadline.hasExpired() ) {
+        finished.wait(&mutex, deadline);
+    }
+    return done;
+}
+
+bool MediaWiki::Search::succeeded() const
+{
+    QMutexLocker locker(&mutex);
+    return success;
+}
+
+QList<MediaWiki::Result> MediaWiki::Search::results() const
+{
+    QMutexLocker locker(&mutex);
+    return resultList;
+}
+
+void MediaWiki::Search::finish( bool ok, const QList<MediaWiki::Result> &results )
+{
+    QMutexLocker locker(&mutex);
+    done = true;
+    success = ok;
+    resultList = results;
+    finished.wakeAll();
+}
+
 MediaWiki::MediaWiki( QObject *parent )
         : QObject( parent ),
           d( new MediaWikiPrivate )
@@ -60,34 +106,23 @@ MediaWiki::MediaWiki( QObject *parent )
     d->manager = new QNetworkAccessManager( this );
     d->manager->setRedirectPolicy(QNetworkRequest::NoLessSafeRedirectPolicy);
     //d->manager = new KIO::AccessManager( this );
-    d->maxItems = 10;
     d->timeout = 30 * 1000; // 30 second
-    d->reply = nullptr;
     d->userAgent = QByteArray("KDE Plasma Silk; MediaWikiRunner; 1.0");
-
-    connect(d->manager, &QNetworkAccessManager::finished, this, &MediaWiki::onNetworkRequestFinished);
 }
 
 MediaWiki::~MediaWiki()
 {
+    // nobody should wait for a reply which can't arrive anymore
+    const auto replies = d->manager->findChildren<QNetworkReply *>();
+    for (QNetworkReply *reply : replies) {
+        reply->abort();
+    }
+    for (auto it = d->waitingSearches.constBegin(); it != d->waitingSearches.constEnd(); ++it) {
+        it.key()->finish(false);
+    }
     delete d;
 }
 
-QList<MediaWiki::Result> MediaWiki::results() const
-{
-    return d->results;
-}
-
-int MediaWiki::maxItems() const
-{
-    return d->maxItems;
-}
-
-void MediaWiki::setMaxItems( int limit )
-{
-    d->maxItems = limit;
-}
-
 QUrl MediaWiki::apiUrl() const
 {
     return d->apiUrl;
@@ -112,39 +147,70 @@ void MediaWiki::setTimeout( int millis )
     d->timeout = millis;
 }
 
-void MediaWiki::abort()
+QSharedPointer<MediaWiki::Search> MediaWiki::search( const QString &searchTerm, int maxItems )
 {
-    if ( !d->reply )
-    return;
+    QSharedPointer<Search> search(new Search);
+    search->term = searchTerm;
+    search->maxItems = maxItems;
+    // the network access manager may only be used from the thread of this object
+    QMetaObject::invokeMethod(this, [this, search] {
+        startSearch(search);
+    }, Qt::QueuedConnection);
+    return search;
+}
 
-    d->reply->abort();
-    d->reply = nullptr;
+void MediaWiki::abort( const QSharedPointer<Search> &search )
+{
+    QMetaObject::invokeMethod(this, [this, search] {
+        if ( d->waitingSearches.remove(search) ) {
+            search->finish(false);
+        } else if ( QNetworkReply *reply = d->searchReplies.value(search.data()) ) {
+            // finishes the search
+            reply->abort();
+        }
+    }, Qt::QueuedConnection);
 }
 
-void MediaWiki::search( const QString &searchTerm )
+void MediaWiki::startSearch( const QSharedPointer<Search> &search )
 {
+    {
+        QMutexLocker locker(&search->mutex);
+        if ( search->done ) {
+            return;
+        }
+    }
+
+    // https://en.wikipedia.org/w/api.php?action=opensearch&format=json&search=plasma&limit=3&namespace=0
+    // lists the matching titles with their URLs, much lighter than list=search
     QUrl url = d->apiUrl;
     QUrlQuery urlQuery(url);
-    urlQuery.addQueryItem(QStringLiteral("action"), QStringLiteral("query"));
-    urlQuery.addQueryItem(QStringLiteral("format"), QStringLiteral("xml"));
-    urlQuery.addQueryItem(QStringLiteral("list"), QStringLiteral("search"));
-    urlQuery.addQueryItem(QStringLiteral("srsearch"), searchTerm );
-    urlQuery.addQueryItem(QStringLiteral("srlimit"), QString::number(d->maxItems));
+    urlQuery.addQueryItem(QStringLiteral("action"), QStringLiteral("opensearch"));
+    urlQuery.addQueryItem(QStringLiteral("format"), QStringLiteral("json"));
+    urlQuery.addQueryItem(QStringLiteral("search"), search->term );
+    urlQuery.addQueryItem(QStringLiteral("limit"), QString::number(search->maxItems));
+    urlQuery.addQueryItem(QStringLiteral("namespace"), QStringLiteral("0"));
     url.setQuery(urlQuery);
 
     qDebug() << "Constructed search URL" << url;
 
-    if ( d->state == StateReady ) {
-        QNetworkRequest req(url);
-        req.setRawHeader( QByteArray("User-Agent"), d->userAgent );
-        qDebug() << "mediawiki User-Agent" << req.rawHeader(QByteArray("UserAgent"));
+    QNetworkReply *reply = get( url );
+    d->searchReplies.insert(search.data(), reply);
+    connect(reply, &QNetworkReply::finished, this, [this, reply, search] {
+        d->searchReplies.remove(search.data());
+        onSearchRequestFinished(reply, search);
+    });
+}
 
-        d->reply = d->manager->get( req );
-        QTimer::singleShot( d->timeout, this, SLOT(abort()) );
-    } else if ( d->state == StateApiChanged ) {
-        d->query = url;
-        findBase();
-    }
+QNetworkReply *MediaWiki::get( const QUrl &url )
+{
+    QNetworkRequest req(url);
+    req.setRawHeader( QByteArray("User-Agent"), d->userAgent );
+    // several searches share a single connection to the wiki
+    req.setAttribute( QNetworkRequest::HTTP2AllowedAttribute, true );
+
+    QNetworkReply *reply = d->manager->get( req );
+    QTimer::singleShot( d->timeout, reply, &QNetworkReply::abort );
+    return reply;
 }
 
 void MediaWiki::findBase()
@@ -158,43 +224,127 @@ void MediaWiki::findBase()
     url.setQuery(urlQuery);
 
     qDebug() << "Constructed base query URL" << url;
-    QNetworkRequest req(url);
-    req.setRawHeader( QByteArray("User-Agent"), d->userAgent );
 
-    d->reply = d->manager->get( req );
+    QNetworkReply *reply = get( url );
+    connect(reply, &QNetworkReply::finished, this, [this, reply] {
+        onBaseRequestFinished(reply);
+    });
     d->state = StateApiUpdating;
 }
 
-void MediaWiki::onNetworkRequestFinished(QNetworkReply *reply)
+void MediaWiki::onBaseRequestFinished( QNetworkReply *reply )
 {
-    if ( reply->error() != QNetworkReply::NoError ) {
+    reply->deleteLater();
+    const auto waitingSearches = d->waitingSearches;
+    d->waitingSearches.clear();
+
+    if ( reply->error() != QNetworkReply::NoError || !processBaseResult( reply ) ) {
         qDebug() << "Request failed, " << reply->errorString();
-        reply->deleteLater();
-        d->reply = nullptr;
-        emit finished(false);
+        // ask again with the next search
+        d->state = StateApiChanged;
+        for (auto it = waitingSearches.constBegin(); it != waitingSearches.constEnd(); ++it) {
+            it.key()->finish(false);
+        }
         return;
     }
 
     qDebug() << "Request succeeded" << d->apiUrl;
+    d->state = StateReady;
+    saveSiteInfo();
 
-    if ( d->state == StateApiUpdating ) {
-        bool ok = processBaseResult( reply );
-        Q_UNUSED ( ok );
-        reply->deleteLater();
-        reply= nullptr;
+    for (auto it = waitingSearches.constBegin(); it != waitingSearches.constEnd(); ++it) {
+        finishSearch(it.key(), it.value());
+    }
+}
+
+void MediaWiki::onSearchRequestFinished( QNetworkReply *reply, const QSharedPointer<Search> &search )
+{
+    reply->deleteLater();
+
+    if ( reply->error() != QNetworkReply::NoError ) {
+        qDebug() << "Request failed, " << reply->errorString();
+        search->finish(false);
+        return;
+    }
+
+    QList<MediaWiki::Result> results;
+    if ( !processSearchResult( reply->readAll(), &results ) ) {
+        search->finish(false);
+        return;
+    }
+
+    // wikis used to leave the URLs out, only then the base URL is needed
+    const bool lacksUrl = std::any_of(results.cbegin(), results.cend(), [](const Result &result) {
+        return result.url.isEmpty();
+    });
+    if ( lacksUrl && d->state == StateApiChanged && loadSiteInfo() ) {
         d->state = StateReady;
+    }
+    if ( !lacksUrl || d->state == StateReady ) {
+        finishSearch(search, results);
+        return;
+    }
+
+    d->waitingSearches.insert(search, results);
+    if ( d->state == StateApiChanged ) {
+        findBase();
+    }
+}
+
+void MediaWiki::finishSearch( const QSharedPointer<Search> &search, QList<MediaWiki::Result> results )
+{
+    for ( Result &result : results ) {
+        if ( result.url.isEmpty() ) {
+            // the title leads to the page as well
+            result.url = d->baseUrl.resolved(QUrl(result.title));
+        }
+    }
+    search->finish( true, results );
+}
+
+QString MediaWiki::siteInfoCacheFile() const
+{
+    const QByteArray hash = QCryptographicHash::hash(d->apiUrl.toEncoded(), QCryptographicHash::Sha1).toHex();
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+        + QStringLiteral("/krunner_mediawiki/") + QString::fromLatin1(hash);
+}
 
-        QNetworkRequest req(d->query);
-        req.setRawHeader( QByteArray("User-Agent"), d->userAgent );
-        d->reply = d->manager->get( req );
-        QTimer::singleShot( d->timeout, this, SLOT(abort()) );
-    } else {
-        bool ok = processSearchResult( reply );
+bool MediaWiki::loadSiteInfo()
+{
+    QFile file(siteInfoCacheFile());
+    if ( !file.open(QIODevice::ReadOnly) ) {
+        return false;
+    }
 
-        emit finished( ok );
-        d->reply->deleteLater();
-        d->reply = nullptr;
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+    quint32 magic;
+    QUrl apiUrl;
+    QUrl baseUrl;
+    QDateTime fetched;
+    stream >> magic >> apiUrl >> baseUrl >> fetched;
+    if ( stream.status() != QDataStream::Ok || magic != s_siteInfoMagic || apiUrl != d->apiUrl
+         || fetched.daysTo(QDateTime::currentDateTimeUtc()) >= s_siteInfoMaxAgeDays ) {
+        return false;
     }
+
+    d->baseUrl = baseUrl;
+    return true;
+}
+
+void MediaWiki::saveSiteInfo()
+{
+    const QString fileName = siteInfoCacheFile();
+    QDir().mkpath(QFileInfo(fileName).path());
+
+    QSaveFile file(fileName);
+    if ( !file.open(QIODevice::WriteOnly) ) {
+        return;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+    stream << s_siteInfoMagic << d->apiUrl << d->baseUrl << QDateTime::currentDateTimeUtc();
+    file.commit();
 }
 
 bool MediaWiki::processBaseResult( QIODevice *source )
@@ -218,29 +368,26 @@ bool MediaWiki::processBaseResult( QIODevice *source )
     return true;
 }
 
-bool MediaWiki::processSearchResult( QIODevice *source )
+bool MediaWiki::processSearchResult( const QByteArray &data, QList<MediaWiki::Result> *results )
 {
-    d->results.clear();
-
-    QXmlStreamReader reader( source );
-    while ( !reader.atEnd() ) {
-        QXmlStreamReader::TokenType tokenType = reader.readNext();
-        // qDebug() << "Token" << int(tokenType);
-        if ( tokenType == QXmlStreamReader::StartElement ) {
-            if (reader.name() == QLatin1String("p")) {
-                QXmlStreamAttributes attrs = reader.attributes();
+    // [ "term", [ titles... ], [ descriptions... ], [ urls... ] ]
+    const QJsonDocument document = QJsonDocument::fromJson( data );
+    const QJsonArray response = document.array();
+    if ( response.size() < 2 ) {
+        return false;
+    }
 
-                Result r;
-                r.title = attrs.value(QStringLiteral("title")).toString();
-                r.url = d->baseUrl.resolved(QUrl(r.title));
+    const QJsonArray titles = response.at(1).toArray();
+    const QJsonArray urls = response.at(3).toArray();
+    for ( int i = 0; i < titles.size(); ++i ) {
+        Result r;
+        r.title = titles.at(i).toString();
+        // empty if the wiki left it out, see finishSearch()
+        r.url = QUrl(urls.at(i).toString());
 
-                qDebug() << "Got result: url=" << r.url << "title=" << r.title;
+        qDebug() << "Got result: url=" << r.url << "title=" << r.title;
 
-                d->results.prepend( r );
-            }
-        } else if ( tokenType == QXmlStreamReader::Invalid ) {
-            return false;
-        }
+        results->prepend( r );
     }
     return true;
 }
@@ -24,7 +24,10 @@
 // Qt
 #include <QObject>
 #include <QList>
+#include <QMutex>
+#include <QSharedPointer>
 #include <QUrl>
+#include <QWaitCondition>
 
 class QNetworkReply;
 class QIODevice;
@@ -32,6 +35,11 @@ class QIODevice;
 /**
  * Searches MediaWiki based wikis like wikipedia and techbase.
  *
+ * One object serves all searches of a runner, so the connection to the wiki
+ * and what it told about itself are reused between them. It is meant to live
+ * in a thread with an event loop of its own, search() can be called from any
+ * thread.
+ *
  * @author Richard Moore, rich@kde.org
  */
 class MediaWiki : public QObject
@@ -66,27 +74,42 @@ public:
     };
 
     /**
-     * Create a media wiki querying object with the specified parent. The querying
-     * object can be used for multiple queries, though only one can be performed at
-     * a time.
-     * @param parent The parent object
+     * A search started by search(), to wait for its results from another thread.
      */
-    explicit MediaWiki(QObject *parent = nullptr);
-    ~MediaWiki() override;
+    class Search {
+        public:
+            /**
+             * Waits up to @p millis milliseconds for the search to finish.
+             * @returns true if it has finished
+             */
+            bool waitForFinished( int millis );
+
+            /** @returns true if the search has finished successfully. */
+            bool succeeded() const;
+
+            /** @returns a list of matches, once finished. */
+            QList<MediaWiki::Result> results() const;
+
+        private:
+            friend class MediaWiki;
+            void finish( bool ok, const QList<MediaWiki::Result> &results = QList<MediaWiki::Result>() );
+
+            QString term;
+            int maxItems = 10;
+
+            mutable QMutex mutex;
+            QWaitCondition finished;
+            bool done = false;
+            bool success = false;
+            QList<MediaWiki::Result> resultList;
+    };
 
     /**
-     * @returns a list of matches.
-     */
-    QList<MediaWiki::Result> results() const;
-
-    /** @returns the currently specified maximum number of results to return. */
-    int maxItems() const;
-
-    /** Sets the maximum number of results to return.
-     *
-     * @param limit Maximum number number of results to retrieve
+     * Create a media wiki querying object with the specified parent.
+     * @param parent The parent object
      */
-    void setMaxItems( int limit );
+    explicit MediaWiki(QObject *parent = nullptr);
+    ~MediaWiki() override;
 
     /** @returns the currently specified API URL. */
     QUrl apiUrl() const;
@@ -95,6 +118,8 @@ public:
      * Sets the URL at which the wikis API page can be found. For example, wikipedia
      * has the API file at https://en.wikipedia.org/w/api.php whilst techbase has the
      *
+     * Must be set before the first search.
+     *
      * @param url The URL of the api.php file, for example https://techbase.kde.org/api.php
      */
     void setApiUrl( const QUrl &url );
@@ -103,38 +128,39 @@ public:
     int timeout() const;
 
     /**
-     * Sets timeout in milliseconds. Once the specified time has elapsed, the current
-     * query is aborted.
+     * Sets timeout in milliseconds. Once the specified time has elapsed, a
+     * request is aborted.
      *
      * @param millis Query timeout in milliseconds
      */
     void setTimeout( int millis );
 
-Q_SIGNALS:
     /**
-     * Emitted when a search has been completed.
-     * @param success true if the search was completed successfully.
-     */
-    void finished( bool success );
-
-public Q_SLOTS:
-    /**
-     * Search the wiki for the specified search term.
+     * Search the wiki for the specified search term. May be called from any thread.
+     *
+     * @param searchTerm The text to look for
+     * @param maxItems Maximum number number of results to retrieve
      */
-    void search( const QString &searchTerm );
+    QSharedPointer<Search> search( const QString &searchTerm, int maxItems );
 
     /**
-     * Aborts the currently running request.
+     * Aborts a search which is no longer of interest, finishing it unsuccessfully.
+     * May be called from any thread.
      */
-    void abort();
-
-private Q_SLOTS:
-    void onNetworkRequestFinished(QNetworkReply *reply);
+    void abort( const QSharedPointer<Search> &search );
 
 private:
+    void startSearch( const QSharedPointer<Search> &search );
     void findBase();
+    void onBaseRequestFinished( QNetworkReply *reply );
+    void onSearchRequestFinished( QNetworkReply *reply, const QSharedPointer<Search> &search );
+    void finishSearch( const QSharedPointer<Search> &search, QList<MediaWiki::Result> results );
+    QNetworkReply *get( const QUrl &url );
     bool processBaseResult( QIODevice *source );
-    bool processSearchResult( QIODevice *source );
+    bool processSearchResult( const QByteArray &data, QList<MediaWiki::Result> *results );
+    QString siteInfoCacheFile() const;
+    bool loadSiteInfo();
+    void saveSiteInfo();
 
     struct MediaWikiPrivate * const d;
 };
@@ -26,15 +26,18 @@
 #include <KServiceTypeTrader>
 #include <KLocalizedString>
 // Qt
-#include <QMutex>
-#include <QEventLoop>
-#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QThread>
 #include <QDesktopServices>
 #include <QDebug>
 
 
+// how often a waiting match checks whether the user typed on
+static const int s_pollInterval = 20;
+
 MediaWikiRunner::MediaWikiRunner(QObject *parent, const QVariantList &args)
     : Plasma::AbstractRunner(parent, args)
+    , m_results(64)
 {
     setObjectName(QStringLiteral("MediaWikiRunner"));
 
@@ -55,21 +58,37 @@ MediaWikiRunner::MediaWikiRunner(QObject *parent, const QVariantList &args)
         m_iconName = info.icon();
     }
 
+    // lets the runner benchmarks answer the searches from a local stand-in server
+    const QByteArray standInApiUrl = qgetenv("PLASMA_MEDIAWIKI_TEST_API_URL");
+    if (!standInApiUrl.isEmpty()) {
+        m_apiUrl = QUrl(QString::fromLatin1(standInApiUrl));
+    }
+
 
     addSyntax(Plasma::RunnerSyntax(QStringLiteral("wiki :q:"), i18n("Searches %1 for :q:.", m_name)));
 
     setSpeed( SlowSpeed );
+
+    m_networkThread = new QThread(this);
+    m_networkThread->setObjectName(QStringLiteral("MediaWikiRunner network"));
+    m_mediaWiki = new MediaWiki;
+    m_mediaWiki->setApiUrl(m_apiUrl);
+    m_mediaWiki->moveToThread(m_networkThread);
+    connect(m_networkThread, &QThread::finished, m_mediaWiki, &QObject::deleteLater);
+    m_networkThread->start();
 }
 
 MediaWikiRunner::~MediaWikiRunner()
 {
+    m_networkThread->quit();
+    m_networkThread->wait();
 }
 
 
 void MediaWikiRunner::match(Plasma::RunnerContext &context)
 {
     // Check for networkconnection
-    if (!m_networkConfigurationManager.isOnline() ||
+    if (!(m_networkConfigurationManager.isOnline() || qEnvironmentVariableIsSet("PLASMA_MEDIAWIKI_TEST_API_URL")) ||
         !m_apiUrl.isValid()) {
         return;
     }
@@ -89,31 +108,46 @@ void MediaWikiRunner::match(Plasma::RunnerContext &context)
         return;
     }
 
-    QEventLoop loop;
-    // Wait a second, we don't want to  query on every keypress
-    QMutex mutex;
-    QWaitCondition waiter;
-    mutex.lock();
-    waiter.wait(&mutex, 1000);
-    mutex.unlock();
-
-    if (!context.isValid()) {
-        return;
+    const int pause = typingPause();
+    const int maxItems = context.singleRunnerQueryMode() ? 10 : 3;
+    const QString cacheKey = QString::number(maxItems) + QLatin1Char(':') + term;
+    QList<MediaWiki::Result> results;
+    bool cached = false;
+    {
+        QMutexLocker locker(&m_resultsLock);
+        if (const QList<MediaWiki::Result> *cachedResults = m_results.object(cacheKey)) {
+            results = *cachedResults;
+            cached = true;
+        }
     }
 
-    MediaWiki mediawiki;
-    if (context.singleRunnerQueryMode()) {
-        mediawiki.setMaxItems(10);
-    } else {
-        mediawiki.setMaxItems(3);
-    }
-    mediawiki.setApiUrl( m_apiUrl );
-    connect(&mediawiki, &MediaWiki::finished, &loop, &QEventLoop::quit);
+    if (!cached) {
+        // Don't query on every keypress: wait until the user paused typing for a
+        // bit longer than usual, every further keypress invalidates the context
+        if (!waitWhileValid(context, pause)) {
+            return;
+        }
 
-    mediawiki.search(term);
-    qDebug() << "Wikisearch:" << m_name << term;
+        const auto search = m_mediaWiki->search(term, maxItems);
+        qDebug() << "Wikisearch:" << m_name << term;
+
+        // the requests for the site info and the search time out on their own
+        QElapsedTimer searchTime;
+        searchTime.start();
+        while (!search->waitForFinished(s_pollInterval)) {
+            if (!context.isValid() || searchTime.hasExpired(2 * 30 * 1000 + 1000)) {
+                m_mediaWiki->abort(search);
+                return;
+            }
+        }
 
-    loop.exec();
+        if (!search->succeeded()) {
+            return;
+        }
+        results = search->results();
+        QMutexLocker locker(&m_resultsLock);
+        m_results.insert(cacheKey, new QList<MediaWiki::Result>(results));
+    }
 
     if (!context.isValid()) {
         return;
@@ -121,7 +155,7 @@ void MediaWikiRunner::match(Plasma::RunnerContext &context)
     qreal relevance = 0.5;
     qreal stepRelevance = 0.1;
 
-    foreach(const MediaWiki::Result& res, mediawiki.results()) {
+    foreach(const MediaWiki::Result& res, results) {
         qDebug() << "Match:" << res.url << res.title;
         Plasma::QueryMatch match(this);
         match.setType(Plasma::QueryMatch::PossibleMatch);
@@ -135,6 +169,27 @@ void MediaWikiRunner::match(Plasma::RunnerContext &context)
     }
 }
 
+int MediaWikiRunner::typingPause()
+{
+    QMutexLocker locker(&m_typingLock);
+    // pauses longer than this are no typing but thinking
+    if (m_sinceLastQuery.isValid() && m_sinceLastQuery.elapsed() < 2000) {
+        m_keystrokeInterval = (3 * m_keystrokeInterval + m_sinceLastQuery.elapsed()) / 4;
+    }
+    m_sinceLastQuery.start();
+    return qBound<qint64>(150, 2 * m_keystrokeInterval, 1000);
+}
+
+bool MediaWikiRunner::waitWhileValid(const Plasma::RunnerContext &context, int millis)
+{
+    QElapsedTimer waited;
+    waited.start();
+    while (context.isValid() && !waited.hasExpired(millis)) {
+        QThread::msleep(qMin<qint64>(s_pollInterval, millis - waited.elapsed()));
+    }
+    return context.isValid();
+}
+
 void MediaWikiRunner::run(const Plasma::RunnerContext &context, const Plasma::QueryMatch &match)
 {
     Q_UNUSED(context)
@@ -22,9 +22,17 @@
 
 // KF
 #include <KRunner/AbstractRunner>
+
+#include "mediawiki.h"
+
 // Qt
+#include <QCache>
+#include <QElapsedTimer>
+#include <QMutex>
 #include <QNetworkConfigurationManager>
 
+class QThread;
+
 
 class MediaWikiRunner : public Plasma::AbstractRunner
 {
@@ -38,11 +46,26 @@ public:
     void run(const Plasma::RunnerContext &context, const Plasma::QueryMatch &match) override;
 
 private:
+    int typingPause();
+    static bool waitWhileValid(const Plasma::RunnerContext &context, int millis);
+
     QString m_iconName;
     QString m_name;
     QString m_comment;
     QUrl m_apiUrl;
 
+    // the wiki is asked from a thread of its own, keeping the connection between searches
+    QThread *m_networkThread;
+    MediaWiki *m_mediaWiki;
+
+    // the results of recent searches, by maximum number of items and term
+    QCache<QString, QList<MediaWiki::Result>> m_results;
+    QMutex m_resultsLock;
+    // how fast the user types, to tell when they stopped
+    QMutex m_typingLock;
+    QElapsedTimer m_sinceLastQuery;
+    qint64 m_keystrokeInterval = 300;
+
     QNetworkConfigurationManager m_networkConfigurationManager;
 };
 
@@ -23,13 +23,22 @@
 #include <QDebug>
 #include <QLocale>
 #include <QSet>
+#include <QTimer>
 #include <QIcon>
 #include <QMimeData>
 
 #include <KLocalizedString>
 
+namespace {
+//After a session, spellers of other languages than the default one are dropped after a short while,
+//the default speller and the language catalogue only after a long idle period
+const int s_trimDelay = 5 * 60 * 1000;
+const int s_releaseDelay = 60 * 60 * 1000;
+}
+
 SpellCheckRunner::SpellCheckRunner(QObject* parent, const QVariantList &args)
     : Plasma::AbstractRunner(parent, args)
+    , m_suggestions(256)
 {
     Q_UNUSED(args)
     setObjectName(QStringLiteral("Spell Checker"));
@@ -45,6 +54,10 @@ void SpellCheckRunner::init()
                            QIcon::fromTheme(QStringLiteral("edit-copy")),
                            i18nc("@action", "Copy to Clipboard"))};
 
+    m_idleTimer = new QTimer(this);
+    m_idleTimer->setSingleShot(true);
+    connect(m_idleTimer, &QTimer::timeout, this, &SpellCheckRunner::releaseIdleSpellers);
+
     //Connect prepare and teardown signals
     connect(this, &SpellCheckRunner::prepare, this, &SpellCheckRunner::loadData);
     connect(this, &SpellCheckRunner::teardown, this, &SpellCheckRunner::destroydata);
@@ -55,16 +68,22 @@ void SpellCheckRunner::init()
 //Load a default dictionary and some locale names
 void SpellCheckRunner::loadData()
 {
-    //Load the default speller, with the default language
-    auto defaultSpellerIt = m_spellers.find(QString());
-    if (defaultSpellerIt == m_spellers.end()) {
-        defaultSpellerIt = m_spellers.insert(QString(), QSharedPointer<Sonnet::Speller> (new Sonnet::Speller(QString())));
+    m_idleTimer->stop();
+    m_trimmed = false;
+
+    //Load the default speller, with the default language; usually still warm from the last session
+    QSharedPointer<Sonnet::Speller> defaultSpeller = checkOutSpeller(QString());
+
+    //The catalogue is kept as well, until released after a long idle period
+    if (!m_availableLanguages.isEmpty()) {
+        checkInSpeller(QString(), defaultSpeller);
+        return;
     }
-    auto& defaultSpeller = defaultSpellerIt.value();
 
     //store all language names, makes it possible to type "spell german TERM" if english locale is set
     //Need to construct a map between natual language names and names the spell-check recognises.
     const QStringList avail = defaultSpeller->availableLanguages();
+    m_availableLanguages = avail;
     //We need to filter the available languages so that we associate the natural language
     //name (eg. 'german') with one sub-code.
     QSet<QString> families;
@@ -102,12 +121,84 @@ void SpellCheckRunner::loadData()
         }
     }
 
+    checkInSpeller(QString(), defaultSpeller);
 }
 
 void SpellCheckRunner::destroydata()
 {
-    //Clear the data arrays to save memory
+    //Keep everything for the next session for now, releaseIdleSpellers() saves the memory later
+    m_idleTimer->start(s_trimDelay);
+}
+
+void SpellCheckRunner::releaseIdleSpellers()
+{
+    QMutexLocker lock(&m_spellLock);
+
+    if (!m_trimmed) {
+        //Keep one warm default speller, dictionaries of other languages are rarely asked for again
+        const QSharedPointer<Sonnet::Speller> defaultSpeller = m_spellers.value(QString()).value(0);
+        m_spellers.clear();
+        if (defaultSpeller) {
+            m_spellers[QString()].append(defaultSpeller);
+        }
+        m_trimmed = true;
+        m_idleTimer->start(s_releaseDelay - s_trimDelay);
+        return;
+    }
+
+    //Long unused, clear the data arrays to save memory; also picks up dictionaries installed meanwhile
     m_spellers.clear();
+    m_availableLanguages.clear();
+    m_languages.clear();
+
+    QMutexLocker suggestionsLock(&m_suggestionsLock);
+    m_suggestions.clear();
+}
+
+QSharedPointer<Sonnet::Speller> SpellCheckRunner::checkOutSpeller(const QString &lang)
+{
+    {
+        QMutexLocker lock(&m_spellLock);
+        auto it = m_spellers.find(lang);
+        if (it != m_spellers.end() && !it->isEmpty()) {
+            return it->takeLast();
+        }
+    }
+
+    //All spellers of this language are busy, or there is none yet;
+    //constructed without the lock so other threads are not held up by loading the dictionary
+    return QSharedPointer<Sonnet::Speller>(new Sonnet::Speller(lang));
+}
+
+void SpellCheckRunner::checkInSpeller(const QString &lang, const QSharedPointer<Sonnet::Speller> &speller)
+{
+    QMutexLocker lock(&m_spellLock);
+    m_spellers[lang].append(speller);
+}
+
+bool SpellCheckRunner::suggest(const QString &lang, const QString &word, Suggestions *result)
+{
+    const QPair<QString, QString> key(lang, word);
+    {
+        QMutexLocker lock(&m_suggestionsLock);
+        if (const Suggestions *cached = m_suggestions.object(key)) {
+            *result = *cached;
+            return true;
+        }
+    }
+
+    const QSharedPointer<Sonnet::Speller> speller = checkOutSpeller(lang);
+    const bool valid = speller->isValid();
+    if (valid) {
+        result->correct = speller->checkAndSuggest(word, result->terms);
+    }
+    checkInSpeller(lang, speller);
+
+    if (valid) {
+        QMutexLocker lock(&m_suggestionsLock);
+        m_suggestions.insert(key, new Suggestions(*result));
+    }
+    return valid;
 }
 
 void SpellCheckRunner::reloadConfiguration()
@@ -132,9 +223,8 @@ void SpellCheckRunner::reloadConfiguration()
  * Return the empty string if we can't match a language. */
 QString SpellCheckRunner::findLang(const QStringList& terms)
 {
-    const auto &defaultSpeller = m_spellers[QString()];
     //If first term is a language code (like en_GB), set it as the spell-check language
-    if (!terms.isEmpty() && defaultSpeller->availableLanguages().contains(terms[0])) {
+    if (!terms.isEmpty() && m_availableLanguages.contains(terms[0])) {
         return terms[0];
     }
     //If we have two terms and the first is a language name (eg 'french'),
@@ -157,10 +247,8 @@ QString SpellCheckRunner::findLang(const QStringList& terms)
         }
 
         if (!code.isEmpty()) {
-            //We found a valid language! Check still available
-            const QStringList avail = defaultSpeller->availableLanguages();
-            //Does the spell-checker like it?
-            if (avail.contains(code)) {
+            //We found a valid language! Does the spell-checker like it?
+            if (m_availableLanguages.contains(code)) {
                 return code;
             }
         }
@@ -186,42 +274,27 @@ void SpellCheckRunner::match(Plasma::RunnerContext &context)
         query = query.mid(len).trimmed();
     }
 
-    //Pointer to speller object with our chosen language
-    QSharedPointer<Sonnet::Speller> speller = m_spellers[QString()];
-
-    if (speller->isValid()) {
 #if QT_VERSION < QT_VERSION_CHECK(5, 15, 0)
-        QStringList terms = query.split(QLatin1Char(' '), QString::SkipEmptyParts);
+    QStringList terms = query.split(QLatin1Char(' '), QString::SkipEmptyParts);
 #else
-        QStringList terms = query.split(QLatin1Char(' '), Qt::SkipEmptyParts);
+    QStringList terms = query.split(QLatin1Char(' '), Qt::SkipEmptyParts);
 #endif
-        const QString lang = findLang(terms);
-        //If we found a language, create a new speller object using it.
-        if (!lang.isEmpty()) {
-            //First term is the language
-            terms.removeFirst();
-            //New speller object if we don't already have one
-            if (!m_spellers.contains(lang)) {
-                QMutexLocker lock (&m_spellLock);
-                //Check nothing happened while we were acquiring the lock
-                if (!m_spellers.contains(lang)) {
-                    m_spellers[lang] = QSharedPointer<Sonnet::Speller>(new Sonnet::Speller(lang));
-                }
-            }
-            speller = m_spellers[lang];
-            //Rejoin the strings
-            query = terms.join(QLatin1Char(' '));
-        }
+    //If we found a language, check the spelling in it, otherwise in the default one
+    const QString lang = findLang(terms);
+    if (!lang.isEmpty()) {
+        //First term is the language
+        terms.removeFirst();
+        //Rejoin the strings
+        query = terms.join(QLatin1Char(' '));
     }
 
     if (query.size() < 2) {
         return;
     }
 
-    if (speller->isValid()) {
-        QStringList suggestions;
-        const bool correct = speller->checkAndSuggest(query,suggestions);
-        if (correct) {
+    Suggestions suggestions;
+    if (suggest(lang, query, &suggestions)) {
+        if (suggestions.correct) {
             Plasma::QueryMatch match(this);
             match.setType(Plasma::QueryMatch::InformationalMatch);
             match.setIconName(QStringLiteral("checkbox"));
@@ -230,7 +303,7 @@ void SpellCheckRunner::match(Plasma::RunnerContext &context)
             match.setData(query);
             context.addMatch(match);
         } else {
-            for (const auto& suggestion : qAsConst(suggestions)) {
+            for (const auto& suggestion : qAsConst(suggestions.terms)) {
                 Plasma::QueryMatch match(this);
                 match.setType(Plasma::QueryMatch::InformationalMatch);
                 match.setIconName(QStringLiteral("edit-rename"));
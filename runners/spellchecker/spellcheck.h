@@ -22,8 +22,14 @@
 #include <sonnet/speller.h>
 
 #include <KRunner/AbstractRunner>
+#include <QCache>
+#include <QHash>
 #include <QMutex>
+#include <QPair>
 #include <QSharedPointer>
+#include <QVector>
+
+class QTimer;
 
 /**
  * This checks the spelling of query
@@ -48,15 +54,31 @@ protected Q_SLOTS:
 
     void loadData();
     void destroydata();
+    void releaseIdleSpellers();
 
 private:
+    struct Suggestions {
+        bool correct = false;
+        QStringList terms;
+    };
+
     QString findLang(const QStringList &terms);
+    bool suggest(const QString &lang, const QString &word, Suggestions *result);
+    QSharedPointer<Sonnet::Speller> checkOutSpeller(const QString &lang);
+    void checkInSpeller(const QString &lang, const QSharedPointer<Sonnet::Speller> &speller);
 
     QString m_triggerWord;
     QMap<QString, QString> m_languages;//key=language name, value=language code
+    QStringList m_availableLanguages;
     bool m_requireTriggerWord;
-    QMap<QString, QSharedPointer<Sonnet::Speller> > m_spellers; //spellers
-    QMutex m_spellLock; //Lock held when constructing a new speller
+    //Idle spellers per language, a match checks one out so that no speller is used by two threads
+    QHash<QString, QVector<QSharedPointer<Sonnet::Speller> > > m_spellers;
+    QMutex m_spellLock; //Lock held when checking spellers out and in
+    //Results of recent checks, key=(language code, word), so retyped terms are answered right away
+    QCache<QPair<QString, QString>, Suggestions> m_suggestions;
+    QMutex m_suggestionsLock;
+    QTimer *m_idleTimer = nullptr;
+    bool m_trimmed = false;
     QList<QAction *> m_actions;
 };
 
@@ -21,7 +21,6 @@
 
 // KF
 #include <KPluginFactory>
-#include <KIO/Job>
 
 
 %{APPNAME}::%{APPNAME}(QObject *parent, const QVariantList &args)
@@ -30,52 +29,20 @@
     // TODO: replace with url to data about what the current picture of the day is
     const QUrl potdFeed(QStringLiteral("https://kde.org"));
 
-    KIO::StoredTransferJob* job = KIO::storedGet(potdFeed, KIO::NoReload, KIO::HideProgressInfo);
-    connect(job, &KIO::StoredTransferJob::finished,
-            this, &%{APPNAME}::handleFinishedFeedRequest);
-}
-
-%{APPNAME}::~%{APPNAME}()
-{
-}
-
-QImage %{APPNAME}::image() const
-{
-    return mImage;
-}
-
-void %{APPNAME}::handleFinishedFeedRequest(KJob *job)
-{
-    KIO::StoredTransferJob *requestJob = static_cast<KIO::StoredTransferJob*>(job);
-    if (requestJob->error()) {
-        emit error(this);
-        return;
-    }
+    // conditional, unchanged pages are answered with notModified() right away
+    requestPage(potdFeed, [this](const QByteArray &data) {
+        Q_UNUSED(data)
 
-    // TODO: read url to image from requestJob->data()
-    const QUrl picureUrl(QStringLiteral("https://techbase.kde.org/favicon.png"));
+        // TODO: read url to image from data
+        const QUrl picureUrl(QStringLiteral("https://techbase.kde.org/favicon.png"));
 
-    KIO::StoredTransferJob *imageJob = KIO::storedGet(picureUrl, KIO::NoReload, KIO::HideProgressInfo);
-    connect(imageJob, &KIO::StoredTransferJob::finished,
-            this, &%{APPNAME}::handleFinishedImageRequest);
+        // streamed into the cache and decoded off the GUI thread, then finished() is emitted
+        requestImage(picureUrl);
+    });
 }
 
-void %{APPNAME}::handleFinishedImageRequest(KJob *job)
+%{APPNAME}::~%{APPNAME}()
 {
-    KIO::StoredTransferJob *requestJob = static_cast<KIO::StoredTransferJob*>(job);
-    if (requestJob->error()) {
-        emit error(this);
-        return;
-    }
-
-    mImage = QImage::fromData(requestJob->data());
-
-    if (mImage.isNull()) {
-        emit error(this);
-        return;
-    }
-
-    emit finished(this);
 }
 
 
@@ -21,10 +21,6 @@
 #define %{APPNAMEUC}_H
 
 #include <plasma/potdprovider/potdprovider.h>
-// Qt
-#include <QImage>
-
-class KJob;
 
 class %{APPNAME} : public PotdProvider
 {
@@ -43,18 +39,6 @@ public:
      * Destroys the provider.
      */
     ~%{APPNAME}() override;
-
-    /**
-     * Returns the requested image.
-     */
-    QImage image() const override;
-
-private:
-    void handleFinishedFeedRequest(KJob *job);
-    void handleFinishedImageRequest(KJob *job);
-
-private:
-    QImage mImage;
 };
 
 #endif
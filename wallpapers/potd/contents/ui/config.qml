@@ -31,6 +31,10 @@ Kirigami.FormLayout {
     property string cfg_Category
     property int cfg_FillMode
     property alias cfg_Color: colorButton.color
+    property alias cfg_Rotate: rotateCheckBox.checked
+    property var cfg_RotateProviders: []
+    property alias cfg_RotateDays: rotateDaysSpinBox.value
+    property alias cfg_RotateInterval: rotateIntervalSpinBox.value
     property alias formLayout: root
 
     ListModel {
@@ -67,6 +71,7 @@ Kirigami.FormLayout {
 
     QQC2.ComboBox {
         id: providerComboBox
+        enabled: !rotateCheckBox.checked
         Kirigami.FormData.label: i18ndc("plasma_wallpaper_org.kde.potd", "@label:listbox", "Provider:")
         model: providerModel
         textRole: "name"
@@ -198,6 +203,49 @@ Kirigami.FormLayout {
         }
     }
 
+    QQC2.CheckBox {
+        id: rotateCheckBox
+        text: i18ndc("plasma_wallpaper_org.kde.potd", "@option:check", "Rotate through several providers")
+    }
+
+    Repeater {
+        model: rotateCheckBox.checked ? providerModel : null
+        delegate: QQC2.CheckBox {
+            Kirigami.FormData.label: index === 0 ? i18ndc("plasma_wallpaper_org.kde.potd", "@label", "Providers:") : ""
+            text: model.name
+            checked: cfg_RotateProviders.indexOf(model.id) !== -1
+            onToggled: {
+                var providers = cfg_RotateProviders.filter(function (provider) { return provider !== model.id; });
+                if (checked) {
+                    providers.push(model.id);
+                }
+                cfg_RotateProviders = providers;
+            }
+        }
+    }
+
+    QQC2.SpinBox {
+        id: rotateIntervalSpinBox
+        visible: rotateCheckBox.checked
+        Kirigami.FormData.label: i18ndc("plasma_wallpaper_org.kde.potd", "@label:spinbox", "Change every:")
+        from: 1
+        to: 24 * 60
+        textFromValue: function (value) {
+            return i18ndcp("plasma_wallpaper_org.kde.potd", "@item:valuesuffix", "%1 minute", "%1 minutes", value);
+        }
+        valueFromText: function (text) {
+            return parseInt(text);
+        }
+    }
+
+    QQC2.SpinBox {
+        id: rotateDaysSpinBox
+        visible: rotateCheckBox.checked
+        Kirigami.FormData.label: i18ndc("plasma_wallpaper_org.kde.potd", "@label:spinbox", "Include earlier days:")
+        from: 0
+        to: 7
+    }
+
     QQC2.ComboBox {
         id: resizeComboBox
         Kirigami.FormData.label: i18ndc("plasma_wallpaper_org.kde.potd", "@label:listbox", "Positioning:")
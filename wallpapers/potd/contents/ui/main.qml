@@ -18,6 +18,7 @@
  */
 
 import QtQuick 2.5
+import QtQuick.Window 2.2
 import org.kde.plasma.core 2.0 as PlasmaCore
 import org.kde.kquickcontrolsaddons 2.0
 
@@ -26,12 +27,89 @@ Rectangle {
 
     readonly property string provider: wallpaper.configuration.Provider
     readonly property string category: wallpaper.configuration.Category
-    readonly property string identifier: provider === 'unsplash' && category ? provider + ':' + category : provider
+    readonly property string identifier: rotate ? cycle[cycleIndex % cycle.length] : providerIdentifier(provider)
+
+    readonly property bool rotate: wallpaper.configuration.Rotate && cycle.length > 0
+    property int cycleIndex: 0
+    // how many days each provider serves, the others ignore the date and would only
+    // fetch today's picture once more for an earlier day
+    readonly property var recentDays: engine.data["RecentDays"] || ({})
+    // moved on by dayTimer, so the cycle follows the date
+    property date today: new Date()
+    // every picture shown while rotating: each provider's picture of today, then of the earlier days
+    readonly property var cycle: {
+        var providers = wallpaper.configuration.RotateProviders;
+        var result = [];
+        for (var day = 0; day <= wallpaper.configuration.RotateDays; day++) {
+            var date = new Date(today.getTime());
+            date.setDate(date.getDate() - day);
+            for (var i = 0; i < providers.length; i++) {
+                if (day > 0 && !(day < recentDays[providers[i]])) {
+                    continue;
+                }
+                var id = providerIdentifier(providers[i]);
+                result.push(day === 0 ? id : id + ':' + Qt.formatDate(date, "yyyy-MM-dd"));
+            }
+        }
+        return result;
+    }
+    readonly property string nextIdentifier: rotate ? cycle[(cycleIndex + 1) % cycle.length] : ""
+
+    // let the engine decode the pictures at the size they are shown at;
+    // the other fill modes show them unscaled
+    readonly property bool scaled: wallpaper.configuration.FillMode === Image.PreserveAspectCrop
+                                   || wallpaper.configuration.FillMode === Image.Stretch
+                                   || wallpaper.configuration.FillMode === Image.PreserveAspectFit
+    readonly property string sizeSuffix: scaled && width > 0 && height > 0
+                                         ? '@' + Math.round(width * Screen.devicePixelRatio) + 'x' + Math.round(height * Screen.devicePixelRatio)
+                                         : ""
+    readonly property string source: identifier + sizeSuffix
+    // connected ahead of time, so the engine has it fetched and decoded once it is due
+    readonly property string nextSource: nextIdentifier ? nextIdentifier + sizeSuffix : ""
+
+    function providerIdentifier(name) {
+        return name === 'unsplash' && category ? name + ':' + category : name;
+    }
 
     PlasmaCore.DataSource {
         id: engine
         engine: "potd"
-        connectedSources: [identifier]
+        connectedSources: nextSource && nextSource !== source ? ["RecentDays", source, nextSource] : ["RecentDays", source]
+        // keeps showing the previous picture until the new one is decoded
+        onNewData: {
+            if (sourceName === root.source && data.Url) {
+                imageItem.image = data.Image;
+            }
+        }
+    }
+
+    onSourceChanged: {
+        var data = engine.data[source];
+        if (data && data.Url) {
+            imageItem.image = data.Image;
+        }
+    }
+
+    Timer {
+        id: dayTimer
+        running: root.rotate
+        // the engine looks for a new day every ten minutes, see PotdEngine::checkDayChanged()
+        interval: 10 * 60 * 1000
+        repeat: true
+        onTriggered: {
+            var now = new Date();
+            if (now.toDateString() !== root.today.toDateString()) {
+                root.today = now;
+            }
+        }
+    }
+
+    Timer {
+        running: root.rotate && root.cycle.length > 1
+        interval: wallpaper.configuration.RotateInterval * 60 * 1000
+        repeat: true
+        // a picture that could not be fetched leaves the previous one shown until the next turn
+        onTriggered: root.cycleIndex = (root.cycleIndex + 1) % root.cycle.length
     }
 
     Rectangle {
@@ -44,8 +122,8 @@ Rectangle {
     }
 
     QImageItem {
+        id: imageItem
         anchors.fill: parent
-        image: engine.data[identifier].Image
         fillMode: wallpaper.configuration.FillMode
         smooth: true
     }